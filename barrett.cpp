@@ -0,0 +1,143 @@
+#include "barrett.h"
+#include "kernels.h"
+#include "powering.h"
+
+#include <algorithm>
+#include <assert.h>
+
+const uint32_t LOG2_BASE = 32;
+
+barrett_context::barrett_context(big_integer const &modulus) : m(modulus), mod(modulus.digits_qty()) {
+    assert (modulus > 0);
+
+    size_t n = mod.size();
+    to_digits(m, mod.data(), n);
+
+    big_integer quotient = (big_integer(1) << (int32_t) (2 * LOG2_BASE * n)) / m;
+    mu.resize(quotient.digits_qty());
+    to_digits(quotient, mu.data(), mu.size());
+}
+
+big_integer const &barrett_context::modulus() const {
+    return m;
+}
+
+size_t barrett_context::size() const {
+    return mod.size();
+}
+
+size_t barrett_context::scratch_size() const {
+    return 7 * mod.size() + 8;
+}
+
+// Quotient estimate is q = ((x >> (n - 1) digits) * mu) >> (n + 1) digits,
+// it is at most two less than the exact one
+void barrett_context::reduce(uint32_t *res, uint32_t const *x, uint32_t *scratch) const {
+    size_t n = mod.size(), mun = mu.size();
+    uint32_t *q = scratch;
+    uint32_t *qm = q + n + 1 + mun;
+    uint32_t *r = qm + mun + n;
+
+    mul_basecase(q, x + n - 1, n + 1, mu.data(), mun);
+    mul_basecase(qm, q + n + 1, mun, mod.data(), n);
+
+    // Only n + 1 lowest digits matter, the difference is less than 3m
+    sub_n(r, x, qm, n + 1);
+    while (r[n] != 0 || cmp_n(r, mod.data(), n) >= 0) {
+        sub(r, r, n + 1, mod.data(), n);
+    }
+    std::copy(r, r + n, res);
+}
+
+// Digits come from the top in blocks of n, the remainder so far goes above them
+void barrett_context::reduce(uint32_t *res, uint32_t const *x, size_t len, uint32_t *scratch) const {
+    size_t n = mod.size();
+    uint32_t *window = scratch;
+    scratch += 2 * n;
+
+    size_t pos = (len > 2 * n ? len - 2 * n : 0);
+    std::fill(window, window + 2 * n, 0);
+    std::copy(x + pos, x + len, window);
+    reduce(res, window, scratch);
+
+    while (pos > 0) {
+        size_t block = std::min(n, pos);
+        pos -= block;
+        std::fill(window, window + 2 * n, 0);
+        std::copy(x + pos, x + pos + block, window);
+        std::copy(res, res + n, window + block);
+        reduce(res, window, scratch);
+    }
+}
+
+void barrett_context::mul(uint32_t *res, uint32_t const *a, uint32_t const *b, uint32_t *scratch) const {
+    size_t n = mod.size();
+    mul_basecase(scratch, a, n, b, n);
+    reduce(res, scratch, scratch + 2 * n);
+}
+
+void barrett_context::sqr(uint32_t *res, uint32_t const *a, uint32_t *scratch) const {
+    size_t n = mod.size();
+    sqr_basecase(scratch, a, n);
+    reduce(res, scratch, scratch + 2 * n);
+}
+
+big_integer barrett_context::reduce(big_integer const &x) const {
+    size_t n = mod.size(), len = x.digits_qty();
+    std::vector<uint32_t> digits(len), res(n), scratch(scratch_size());
+    to_digits(x, digits.data(), len);
+    reduce(res.data(), digits.data(), len, scratch.data());
+
+    big_integer r = from_digits(res.data(), n);
+    if (x < 0 && r != 0) {
+        r = m - r;
+    }
+    return r;
+}
+
+// All values share one scratch buffer
+void barrett_context::reduce_many(std::vector<big_integer> &values) const {
+    size_t n = mod.size();
+    std::vector<uint32_t> digits, res(n), scratch(scratch_size());
+    for (big_integer &x : values) {
+        size_t len = x.digits_qty();
+        digits.resize(len);
+        to_digits(x, digits.data(), len);
+        reduce(res.data(), digits.data(), len, scratch.data());
+
+        bool negative = x < 0;
+        x = from_digits(res.data(), n);
+        if (negative && x != 0) {
+            x = m - x;
+        }
+    }
+}
+
+big_integer barrett_context::mul(big_integer const &a, big_integer const &b) const {
+    size_t n = mod.size();
+    std::vector<uint32_t> x(n), y(n), scratch(scratch_size());
+    to_digits(a, x.data(), n);
+    to_digits(b, y.data(), n);
+    mul(x.data(), x.data(), y.data(), scratch.data());
+    return from_digits(x.data(), n);
+}
+
+big_integer barrett_context::sqr(big_integer const &a) const {
+    size_t n = mod.size();
+    std::vector<uint32_t> x(n), scratch(scratch_size());
+    to_digits(a, x.data(), n);
+    sqr(x.data(), x.data(), scratch.data());
+    return from_digits(x.data(), n);
+}
+
+big_integer barrett_context::pow(big_integer const &a, big_integer const &e) const {
+    assert (e >= 0);
+
+    size_t n = mod.size();
+    std::vector<uint32_t> x(n), one(n), res(n), scratch(scratch_size());
+    to_digits(a, x.data(), n);
+    one[0] = 1;
+    reduce(one.data(), one.data(), n, scratch.data());
+    sliding_window_pow(*this, res.data(), x.data(), one.data(), e, scratch.data());
+    return from_digits(res.data(), n);
+}
@@ -0,0 +1,49 @@
+#ifndef BIGINT_BARRETT_H
+#define BIGINT_BARRETT_H
+
+#include "big_integer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Reduction modulo fixed m > 0 of any parity.
+ * mu = floor(2^(64 * n) / m) is computed once, n is the number of digits in m,
+ * then x mod m for x < 2^(64 * n) takes two multiplications and
+ * at most two subtractions instead of a division.
+ *
+ * Residues are ordinary numbers from [0, m).
+ * Raw versions work over n-digit arrays and the caller's scratch
+ * of scratch_size() digits, so loops over them never allocate.
+ */
+struct barrett_context {
+    explicit barrett_context(big_integer const& modulus);
+
+    // Any x, including negative and longer than 2n digits
+    big_integer reduce(big_integer const& x) const;
+    void reduce_many(std::vector<big_integer>& values) const;
+
+    big_integer mul(big_integer const& a, big_integer const& b) const;
+    big_integer sqr(big_integer const& a) const;
+    big_integer pow(big_integer const& a, big_integer const& e) const;
+
+    big_integer const& modulus() const;
+    size_t size() const;
+    size_t scratch_size() const;
+
+    // res = x mod m, x has 2n digits
+    void reduce(uint32_t *res, uint32_t const *x, uint32_t *scratch) const;
+    // res = x mod m, x has any length
+    void reduce(uint32_t *res, uint32_t const *x, size_t len, uint32_t *scratch) const;
+    // Output may coincide with any input
+    void mul(uint32_t *res, uint32_t const *a, uint32_t const *b, uint32_t *scratch) const;
+    void sqr(uint32_t *res, uint32_t const *a, uint32_t *scratch) const;
+
+private:
+    big_integer m;
+    std::vector<uint32_t> mod;
+    std::vector<uint32_t> mu;
+};
+
+#endif //BIGINT_BARRETT_H
@@ -1,10 +1,26 @@
 #include "big_integer.h"
+#include "kernels.h"
+#include "thread_pool.h"
+#include "powering.h"
 
 #include <cstring>
 #include <algorithm>
 #include <assert.h>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
 
 const uint32_t LOG2_BASE = 32;
+// Quotients and divisors of at least that many digits are divided through a reciprocal
+const size_t DIV_NEWTON_THRESHOLD = 2500;
+// Reciprocals of that many bits are computed by a single schoolbook division
+const size_t RECIPROCAL_BASECASE_BITS = 2048;
+// Shorter numbers are converted to decimal by repeated division by 10^9
+const size_t TO_STRING_THRESHOLD = 60;
+// Shorter decimal strings are parsed nine characters at a time
+const size_t FROM_STRING_THRESHOLD = 600;
+// Exact quotients of at least that many digits are computed from both ends
+const size_t DIVEXACT_BIDIRECTIONAL_THRESHOLD = 100;
 
 // Removes redundant digits in data
 void refresh(big_integer &a) {
@@ -27,6 +43,7 @@ inline uint32_t cast_to_unsigned(int32_t a) {
     return (a == INT32_MIN) ? (uint32_t) a : abs(a);
 }
 
+
 // big_integer a = (int) b
 big_integer::big_integer(int32_t a) : data(1), negative(a < 0) {
     data[0] = cast_to_unsigned(a);
@@ -37,14 +54,119 @@ big_integer::big_integer(uint32_t a) : data(1), negative(false) {
     data[0] = a;
 }
 
-// big_integer a = (std::string) b, initialize negative is strictly needed
+// big_integer a = (any other integer type) b
+big_integer::big_integer(uint64_t magnitude, bool negative) : data(1), negative(negative && magnitude != 0) {
+    data[0] = (uint32_t) magnitude;
+    if (magnitude >> LOG2_BASE != 0) {
+        data.push_back((uint32_t) (magnitude >> LOG2_BASE));
+    }
+}
+
+namespace {
+    const uint32_t powers_of_ten_32[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+    // len decimal digits at s, nine at a time, each step is one pass over the digits found so far
+    big_integer parse_basecase(char const *s, size_t len) {
+        std::vector<uint32_t> digits(len / 9 + 2);
+        size_t n = 1;
+        for (size_t i = 0, step = (len - 1) % 9 + 1; i < len; i += step, step = 9) {
+            uint32_t chunk = 0;
+            for (size_t j = i; j < i + step; ++j) {
+                assert ('0' <= s[j] && s[j] <= '9');
+                chunk = chunk * 10 + (uint32_t) (s[j] - '0');
+            }
+            uint32_t top = mul_1(digits.data(), digits.data(), n, powers_of_ten_32[step]);
+            top += add_1(digits.data(), digits.data(), n, chunk);
+            if (top > 0) {
+                digits[n++] = top;
+            }
+        }
+        return from_digits(digits.data(), n);
+    }
+
+    /*
+     * len decimal digits at s, powers[i] = 10^(9 * 2^i). The lowest 9 * 2^k digits
+     * and the rest are parsed independently, long ones as parallel tasks,
+     * and joined by one multiplication.
+     */
+    big_integer parse_digits(char const *s, size_t len, std::vector<big_integer> const &powers, bool parallel) {
+        if (len <= FROM_STRING_THRESHOLD) {
+            return parse_basecase(s, len);
+        }
+        size_t k = powers.size() - 1;
+        while (((size_t) 9 << k) >= len) {
+            --k;
+        }
+        size_t low_len = (size_t) 9 << k;
+
+        big_integer high, low;
+        if (parallel && len >= 9 * PARALLEL_MUL_THRESHOLD) {
+            task_group group(default_pool());
+            group.spawn([&] { high = parse_digits(s, len - low_len, powers, parallel); });
+            low = parse_digits(s + len - low_len, low_len, powers, parallel);
+            group.wait();
+        } else {
+            high = parse_digits(s, len - low_len, powers, parallel);
+            low = parse_digits(s + len - low_len, low_len, powers, parallel);
+        }
+        return high * powers[k] + low;
+    }
+
+    uint32_t hex_value(char c) {
+        if ('0' <= c && c <= '9') {
+            return (uint32_t) (c - '0');
+        }
+        assert (('a' <= c && c <= 'f') || ('A' <= c && c <= 'F'));
+        return (uint32_t) ((c | 0x20) - 'a' + 10);
+    }
+
+    // Every digit is made of its own eight characters, so long inputs are cut into parallel blocks
+    big_integer parse_hex(char const *s, size_t len, bool parallel) {
+        std::vector<uint32_t> digits((len + 7) / 8);
+        auto parse_range = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                size_t last = len - 8 * i, first = last < 8 ? 0 : last - 8;
+                uint32_t digit = 0;
+                for (size_t j = first; j < last; ++j) {
+                    digit = (digit << 4) | hex_value(s[j]);
+                }
+                digits[i] = digit;
+            }
+        };
+
+        if (parallel && digits.size() > PARALLEL_MUL_THRESHOLD) {
+            size_t block = PARALLEL_MUL_THRESHOLD;
+            task_group group(default_pool());
+            for (size_t i = block; i < digits.size(); i += block) {
+                group.spawn([&, i] { parse_range(i, std::min(i + block, digits.size())); });
+            }
+            parse_range(0, block);
+            group.wait();
+        } else {
+            parse_range(0, digits.size());
+        }
+        return from_digits(digits.data(), digits.size());
+    }
+}
+
+// Decimal or, after 0x, hexadecimal digits with an optional minus
 big_integer::big_integer(std::string const &str) : data(1), negative(false) {
     assert (!str.empty());
-    data[0] = 0;
-    for (size_t i = (str[0] == '-'); i < str.length(); ++i) {
-        assert ('0' <= str[i] && str[i] <= '9');
-        *this *= 10;
-        *this += str[i] - '0';
+    size_t start = (str[0] == '-');
+    bool parallel = thread_count() > 1;
+    if (str.length() > start + 2 && str[start] == '0' && (str[start + 1] | 0x20) == 'x') {
+        *this = parse_hex(str.data() + start + 2, str.length() - start - 2, parallel);
+    } else {
+        size_t len = str.length() - start;
+        assert (len > 0);
+        std::vector<big_integer> powers;
+        if (len > FROM_STRING_THRESHOLD) {
+            powers.push_back(1000000000);
+            while (((size_t) 18 << (powers.size() - 1)) < len) {
+                powers.push_back(powers.back() * powers.back());
+            }
+        }
+        *this = parse_digits(str.data() + start, len, powers, parallel);
     }
     negative = (str[0] == '-');
     refresh(*this);
@@ -91,6 +213,16 @@ big_integer &big_integer::operator^=(big_integer const &rhs) {
     return *this = *this ^ rhs;
 }
 
+big_integer &big_integer::operator/=(divisor_1 const &rhs) {
+    divrem_1(data.data(), data.data(), data.size(), rhs);
+    refresh(*this);
+    return *this;
+}
+
+big_integer &big_integer::operator%=(divisor_1 const &rhs) {
+    return *this = *this % rhs;
+}
+
 big_integer &big_integer::operator<<=(int rhs) {
     return *this = *this << rhs;
 }
@@ -175,7 +307,7 @@ big_integer operator-(big_integer a, big_integer const &b) {
             return -(-a + b);
         }
     } else if (b.negative) {
-        return a + b;
+        return a + -b;
     }
 
     if (a < b) {
@@ -193,89 +325,464 @@ big_integer operator-(big_integer a, big_integer const &b) {
     return a;
 }
 
+// a * a shares digits with b thanks to copy on write and is squared
 big_integer operator*(big_integer a, big_integer const &b) {
+    big_integer const &x = a;
+    size_t an = x.data.size(), bn = b.data.size();
     big_integer res;
     res.negative = a.negative ^ b.negative;
-    res.data.resize(a.data.size() + b.data.size());
-    for (size_t i = 0; i < a.data.size(); ++i) {
-        uint64_t carry = 0;
-        for (size_t j = 0; j < b.data.size() || carry > 0; ++j) {
-            uint64_t product = res.data[i + j] + (uint64_t) a.data[i] * b.get_digit(j, false) + carry;
-            res.data[i + j] = (uint32_t) product;
-            carry = product >> LOG2_BASE;
-        }
+    res.data.resize(an + bn);
+    // Long products go to the thread pool when it has workers
+    bool parallel = std::min(an, bn) >= PARALLEL_MUL_THRESHOLD && thread_count() > 1;
+    if (x.data.data() == b.data.data()) {
+        (parallel ? sqr_parallel : sqr)(res.data.data(), x.data.data(), an);
+    } else if (an >= bn) {
+        (parallel ? mul_parallel : mul)(res.data.data(), x.data.data(), an, b.data.data(), bn);
+    } else {
+        (parallel ? mul_parallel : mul)(res.data.data(), b.data.data(), bn, x.data.data(), an);
     }
 
     refresh(res);
     return res;
 }
 
+namespace {
+    // powers[i] = 10^(2^i) for i < count, grown on demand and kept for later calls
+    std::vector<big_integer> cached_powers_of_ten(size_t count) {
+        static std::mutex lock;
+        static std::vector<big_integer> powers(1, big_integer(10));
+
+        std::lock_guard<std::mutex> guard(lock);
+        while (powers.size() < count) {
+            powers.push_back(powers.back() * powers.back());
+        }
+        return std::vector<big_integer>(powers.begin(), powers.begin() + count);
+    }
+}
+
+// Left-to-right binary powering of odd part of a, two buffers of the final
+// size are allocated before the loop, factors of two become a shift
+big_integer pow(big_integer const &a, uint64_t e) {
+    static const uint64_t small_powers_of_ten[] = {
+            1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+            1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+            100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+            1000000000000000000ull, 10000000000000000000ull};
+
+    bool negative = a.negative && (e & 1);
+    if (e == 0) {
+        return 1;
+    }
+    if (a == 0 || e == 1) {
+        return a;
+    }
+    if (a == 10 || a == -10) {
+        if (e < 20) {
+            return big_integer(small_powers_of_ten[e], negative);
+        }
+        // A product of the cached 10^(2^i) for the bits of e, without the squarings
+        size_t top = 63;
+        while ((e >> top) == 0) {
+            --top;
+        }
+        std::vector<big_integer> powers = cached_powers_of_ten(top + 1);
+        big_integer res = powers[top];
+        for (size_t i = 0; i < top; ++i) {
+            if ((e >> i) & 1) {
+                res *= powers[i];
+            }
+        }
+        return negative ? -res : res;
+    }
+
+    size_t shift = 0;
+    while (((a.get_digit(shift / LOG2_BASE, false) >> (shift % LOG2_BASE)) & 1) == 0) {
+        ++shift;
+    }
+    big_integer b = (a.negative ? -a : a) >> (int32_t) shift;
+    // The final shift is an int32_t, e is compared before multiplying so nothing overflows
+    if (shift != 0 && e > (uint64_t) INT32_MAX / shift) {
+        throw std::length_error("pow: result is too large");
+    }
+
+    big_integer res(1, negative);
+    if (b != 1) {
+        size_t bn = b.data.size(), bits = LOG2_BASE * bn;
+        while ((b.data.back() >> ((bits - 1) % LOG2_BASE)) == 0) {
+            --bits;
+        }
+        if (e > (SIZE_MAX - LOG2_BASE) / bits) {
+            throw std::length_error("pow: result is too large");
+        }
+        size_t capacity = (bits * e + LOG2_BASE - 1) / LOG2_BASE + 2;
+
+        std::vector<uint32_t> tmp(capacity);
+        res.data.resize(capacity);
+        uint32_t *cur = res.data.data(), *other = tmp.data();
+        uint32_t const *base = static_cast<big_integer const &>(b).data.data();
+        std::copy(base, base + bn, cur);
+        size_t len = bn;
+
+        size_t top = 63;
+        while ((e >> top) == 0) {
+            --top;
+        }
+        for (size_t i = top - 1; i != (size_t) (-1); --i) {
+            sqr(other, cur, len);
+            len *= 2;
+            std::swap(cur, other);
+            while (cur[len - 1] == 0) {
+                --len;
+            }
+
+            if ((e >> i) & 1) {
+                if (bn == 1) {
+                    uint32_t carry = mul_1(cur, cur, len, base[0]);
+                    if (carry > 0) {
+                        cur[len++] = carry;
+                    }
+                } else {
+                    mul(other, cur, len, base, bn);
+                    len += bn;
+                    std::swap(cur, other);
+                    while (cur[len - 1] == 0) {
+                        --len;
+                    }
+                }
+            }
+        }
+
+        if (cur != res.data.data()) {
+            std::copy(cur, cur + len, res.data.data());
+        }
+        res.data.resize(len);
+    }
+
+    return (shift == 0 ? res : res << (int32_t) (shift * e));
+}
+
 big_integer operator/(big_integer a, int32_t b) {
-    big_integer res = a / cast_to_unsigned(b);
-    res.negative ^= b < 0;
-    refresh(res);
-    return res;
+    return a.div_word(cast_to_unsigned(b), b < 0);
 }
 
 big_integer operator/(big_integer a, uint32_t b) {
-    uint32_t carry = 0;
-    for (size_t i = a.data.size() - 1; i != (size_t) (-1); --i) {
-        uint64_t sum = ((uint64_t) carry << LOG2_BASE) + a.data[i];
-        a.data[i] = (uint32_t) (sum / b);
-        carry = sum % b;
+    return a.div_word(b, false);
+}
+
+big_integer operator/(big_integer a, big_integer const &b) {
+    big_integer q, r;
+    divmod(a, b, q, r);
+    return q;
+}
+
+big_integer operator%(big_integer a, big_integer const &b) {
+    big_integer q, r;
+    divmod(a, b, q, r);
+    return r;
+}
+
+namespace {
+    // Approximation of 2^(2n) / a for a of n bits, Newton's iteration doubles the precision
+    big_integer reciprocal(big_integer const &a, size_t n) {
+        if (n <= RECIPROCAL_BASECASE_BITS) {
+            return (big_integer(1) << (int32_t) (2 * n)) / a;
+        }
+        size_t h = n / 2 + 2;
+        big_integer x = reciprocal(a >> (int32_t) (n - h), h) << (int32_t) (n - h);
+        big_integer e = (big_integer(1) << (int32_t) (2 * n)) - a * x;
+        return x + ((x * e) >> (int32_t) (2 * n));
     }
 
-    refresh(a);
-    return a;
+    /*
+     * For a >= b > 0 with a quotient of k bits only the top k + 32 bits of a and b matter:
+     * their product with the reciprocal is the quotient up to a few units, and
+     * the remainder a - q * b corrects it. Everything is a multiplication,
+     * so the division costs a few products instead of a quadratic schoolbook.
+     */
+    void divmod_newton(big_integer const &a, big_integer const &b, big_integer &q, big_integer &r) {
+        int32_t ab = (int32_t) bit_length(a), bb = (int32_t) bit_length(b), p = ab - bb + 33;
+        big_integer x = reciprocal(p <= bb ? b >> (bb - p) : b << (p - bb), (size_t) p);
+        int32_t cut = std::max(ab - p, 0);
+        q = ((a >> cut) * x) >> (p + bb - cut);
+        r = a - q * b;
+        for (; r < 0; r += b) {
+            --q;
+        }
+        for (; r >= b; r -= b) {
+            ++q;
+        }
+    }
 }
 
-big_integer operator/(big_integer a, big_integer const &b) {
-    if (a.negative) {
-        return -(-a / b);
+// Both operands are shifted so that the divisor has the highest bit set
+void divmod(big_integer const &a, big_integer const &b, big_integer &q, big_integer &r) {
+    assert (b != 0);
+
+    size_t an = a.data.size(), bn = b.data.size();
+    uint32_t const *ad = static_cast<opt_vector<uint32_t> const &>(a.data).data();
+    uint32_t const *bd = static_cast<opt_vector<uint32_t> const &>(b.data).data();
+    if (cmp(ad, an, bd, bn) < 0) {
+        r = a;
+        q = 0;
+        return;
+    }
+
+    big_integer quotient, remainder;
+    quotient.negative = a.negative != b.negative;
+    remainder.negative = a.negative;
+    if (bn == 1) {
+        quotient.data.resize(an);
+        remainder.data[0] = divrem_1(quotient.data.data(), ad, an, bd[0]);
+    } else if (bn >= DIV_NEWTON_THRESHOLD && an - bn >= DIV_NEWTON_THRESHOLD) {
+        big_integer x = a, y = b;
+        x.negative = y.negative = false;
+        divmod_newton(x, y, quotient, remainder);
+        quotient.negative = a.negative != b.negative;
+        remainder.negative = a.negative;
+    } else {
+        std::vector<uint32_t> num(an + 1), den(bd, bd + bn);
+        unsigned shift = __builtin_clz(bd[bn - 1]);
+        std::copy(ad, ad + an, num.begin());
+        if (shift > 0) {
+            lshift(den.data(), den.data(), bn, shift);
+            num[an] = lshift(num.data(), num.data(), an, shift);
+        }
+
+        quotient.data.resize(an - bn + 2);
+        divrem_norm(quotient.data.data(), num.data(), an + 1, den.data(), bn);
+        if (shift > 0) {
+            rshift(num.data(), num.data(), bn, shift);
+        }
+        remainder.data.resize(bn);
+        std::copy(num.begin(), num.begin() + bn, remainder.data.data());
     }
-    if (b.negative) {
-        return -(a / -b);
+
+    refresh(quotient);
+    refresh(remainder);
+    q = quotient;
+    r = remainder;
+}
+
+// Odd part of b divides the number shifted by the power of two of b
+big_integer divexact_by_uint32(big_integer const &a, uint32_t b) {
+    assert (b != 0);
+    size_t n = a.data.size();
+    uint32_t const *ad = static_cast<opt_vector<uint32_t> const &>(a.data).data();
+    unsigned shift = __builtin_ctz(b);
+    big_integer res;
+    res.data.resize(n);
+    if (shift > 0) {
+        rshift(res.data.data(), ad, n, shift);
+    } else {
+        std::copy(ad, ad + n, res.data.data());
     }
+    divexact_1(res.data.data(), res.data.data(), n, b >> shift);
+    res.negative = a.negative;
+    refresh(res);
+    return res;
+}
 
-    if (a < b) {
+/*
+ * After both are divided by the power of two of b, b is odd and Hensel's
+ * division gives the quotient from its lowest digit up. Long quotients
+ * are computed from both ends (Jebelean): with the quotient Q of qn digits
+ * and l = qn + 1 - h, the low l digits come from Hensel's division and
+ * floor(Q / B^(l - 1)) from the top 2h digits of a divided by the top h + 2
+ * of b, which is off by at most one. The common digit l - 1 tells which of
+ * the three candidates is right. Hensel's steps get cheaper as they near
+ * digit l, the top division is a square, so h = qn / 3 balances them.
+ */
+big_integer divexact(big_integer const &a, big_integer const &b) {
+    assert (b != 0);
+    size_t an = a.data.size(), bn = b.data.size();
+    if (bn == 1) {
+        big_integer res = divexact_by_uint32(a, b.data[0]);
+        res.negative = res.negative != b.negative;
+        refresh(res);
+        return res;
+    }
+    if (an < bn) {
+        assert (a == 0);
         return 0;
     }
-    if (b.data.size() == 1) {
-        return a / b.data[0];
+    if (bn >= DIV_NEWTON_THRESHOLD && an - bn >= DIV_NEWTON_THRESHOLD) {
+        return a / b;
     }
 
-    auto factor = (uint32_t) ((1ull << LOG2_BASE) / ((uint64_t) (b.data.back() + 1)));
-    big_integer r = a * factor, d = b * factor, res;
-    res.negative = false;
-    size_t n = d.data.size(), res_len = r.data.size() - n;
-    res.data.resize(res_len);
-    if (r >= d << LOG2_BASE * res_len) {
-        res.data.push_back(1);
-        r -= d << LOG2_BASE * res_len;
+    uint32_t const *ad = static_cast<opt_vector<uint32_t> const &>(a.data).data();
+    uint32_t const *bd = static_cast<opt_vector<uint32_t> const &>(b.data).data();
+    size_t zeros = 0;
+    while (bd[zeros] == 0) {
+        ++zeros;
     }
+    std::vector<uint32_t> x(ad + zeros, ad + an), y(bd + zeros, bd + bn);
+    unsigned shift = __builtin_ctz(y[0]);
+    if (shift > 0) {
+        rshift(x.data(), x.data(), x.size(), shift);
+        rshift(y.data(), y.data(), y.size(), shift);
+    }
+    while (y.back() == 0) {
+        y.pop_back();
+    }
+    size_t xn = x.size(), yn = y.size(), qn = xn - yn + 1;
 
-    for (size_t i = res_len - 1; i != (size_t) (-1); --i) {
-        size_t pos = n + i;
-        r.data.resize(std::max(r.data.size(), pos + 1));
-
-        uint64_t quotient = (((uint64_t) r.data[pos] << LOG2_BASE) + r.data[pos - 1]) / d.data[n - 1];
-        uint32_t q = (quotient < UINT32_MAX ? quotient : UINT32_MAX);
-        r -= (q * d) << (LOG2_BASE * i);
+    big_integer res;
+    res.negative = a.negative != b.negative;
+    res.data.resize(qn);
+    size_t h = qn / 3 + 1;
+    if (qn < DIVEXACT_BIDIRECTIONAL_THRESHOLD || yn < h + 2) {
+        divexact_low(res.data.data(), x.data(), qn, y.data(), yn);
+        refresh(res);
+        return res;
+    }
 
-        while (r < 0) {
-            --q;
-            r += (d << (LOG2_BASE * i));
+    size_t l = qn + 1 - h, s = yn - (h + 2);
+    big_integer top = from_digits(x.data() + s + l - 1, xn - s - l + 1) / from_digits(y.data() + s, h + 2);
+    divexact_low(res.data.data(), x.data(), l, y.data(), yn);
+    for (int delta : {0, 1, -1}) {
+        big_integer candidate = top + delta;
+        if (candidate.get_digit(0, false) == res.data[l - 1]) {
+            to_digits(candidate, res.data.data() + l - 1, h);
+            break;
         }
-
-        res.data[i] = q;
     }
+    refresh(res);
+    return res;
+}
+
+big_integer operator/(big_integer a, divisor_1 const &b) {
+    return a /= b;
+}
 
+big_integer operator%(big_integer const &a, divisor_1 const &b) {
+    big_integer res = mod_1(a.data.data(), a.data.size(), b);
+    res.negative = a.negative;
     refresh(res);
     return res;
 }
 
-big_integer operator%(big_integer a, big_integer const &b) {
-    return a - (a / b) * b;
+// Adds b with given sign, in place
+big_integer &big_integer::add_word(uint64_t b, bool b_negative) {
+    uint32_t w[2] = {(uint32_t) b, (uint32_t) (b >> LOG2_BASE)};
+    size_t wn = (w[1] != 0 ? 2 : 1), n = data.size();
+
+    if (negative == b_negative || b == 0) {
+        if (n < wn) {
+            data.resize(wn);
+            n = wn;
+        }
+        uint32_t carry = add(data.data(), data.data(), n, w, wn);
+        if (carry > 0) {
+            data.push_back(carry);
+        }
+        return *this;
+    }
+
+    if (cmp(static_cast<opt_vector<uint32_t> const &>(data).data(), n, w, wn) >= 0) {
+        sub(data.data(), data.data(), n, w, wn);
+    } else {
+        // |a| < |b| means a has at most wn digits
+        data.resize(wn);
+        sub_n(data.data(), w, data.data(), wn);
+        negative = b_negative;
+    }
+
+    refresh(*this);
+    return *this;
+}
+
+big_integer &big_integer::mul_word(uint64_t b, bool b_negative) {
+    if (b >> LOG2_BASE == 0) {
+        uint32_t carry = mul_1(data.data(), data.data(), data.size(), (uint32_t) b);
+        if (carry > 0) {
+            data.push_back(carry);
+        }
+    } else {
+        uint64_t carry = mul_2(data.data(), data.data(), data.size(), b);
+        data.push_back((uint32_t) carry);
+        data.push_back((uint32_t) (carry >> LOG2_BASE));
+    }
+
+    negative ^= b_negative;
+    refresh(*this);
+    return *this;
+}
+
+// Truncates to zero like built-in division
+big_integer &big_integer::div_word(uint64_t b, bool b_negative) {
+    assert (b != 0);
+
+    if (b >> LOG2_BASE != 0) {
+        return *this = *this / big_integer(b, b_negative);
+    }
+
+    divrem_1(data.data(), data.data(), data.size(), (uint32_t) b);
+    negative ^= b_negative;
+    refresh(*this);
+    return *this;
+}
+
+// Remainder has the sign of dividend like built-in one
+big_integer &big_integer::mod_word(uint64_t b) {
+    assert (b != 0);
+
+    if (b >> LOG2_BASE != 0) {
+        return *this = *this % big_integer(b);
+    }
+
+    uint32_t rem = mod_1(static_cast<opt_vector<uint32_t> const &>(data).data(), data.size(), (uint32_t) b);
+    data.resize(1);
+    data[0] = rem;
+    refresh(*this);
+    return *this;
+}
+
+// Two's complement digits are produced on the fly: -x = ~x + 1
+template <typename Op>
+big_integer &big_integer::bit_word(uint64_t b, bool b_negative, Op bit_op) {
+    if (b_negative) {
+        b = 0 - b;
+    }
+    uint32_t a_ext = (negative ? UINT32_MAX : 0), b_ext = (b_negative ? UINT32_MAX : 0);
+    bool res_negative = bit_op(a_ext, b_ext) != 0;
+
+    size_t n = std::max(data.size(), (size_t) 2);
+    data.resize(n);
+    uint32_t *digits = data.data();
+    uint32_t a_carry = 1, res_carry = 1;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t x = digits[i];
+        if (negative) {
+            x = ~x + a_carry;
+            a_carry &= (x == 0);
+        }
+        uint32_t y = (i < 2 ? (uint32_t) (b >> (LOG2_BASE * i)) : b_ext);
+        uint32_t res = bit_op(x, y);
+        if (res_negative) {
+            res = ~res + res_carry;
+            res_carry &= (res == 0);
+        }
+        digits[i] = res;
+    }
+    if (res_negative && res_carry) {
+        data.push_back(1);
+    }
+
+    negative = res_negative;
+    refresh(*this);
+    return *this;
+}
+
+big_integer &big_integer::and_word(uint64_t b, bool b_negative) {
+    return bit_word(b, b_negative, std::bit_and<uint32_t>{});
+}
+
+big_integer &big_integer::or_word(uint64_t b, bool b_negative) {
+    return bit_word(b, b_negative, std::bit_or<uint32_t>{});
+}
+
+big_integer &big_integer::xor_word(uint64_t b, bool b_negative) {
+    return bit_word(b, b_negative, std::bit_xor<uint32_t>{});
 }
 
 big_integer bit_inverse(big_integer a) {
@@ -287,6 +794,26 @@ big_integer bit_inverse(big_integer a) {
     return a;
 }
 
+size_t big_integer::digits_qty() const {
+    return data.size();
+}
+
+void to_digits(big_integer const &a, uint32_t *res, size_t n) {
+    assert (a.data.size() <= n);
+
+    std::copy(a.data.data(), a.data.data() + a.data.size(), res);
+    std::fill(res + a.data.size(), res + n, 0);
+}
+
+big_integer from_digits(uint32_t const *digits, size_t n, bool negative) {
+    big_integer res;
+    res.data.resize(std::max(n, (size_t) 1));
+    std::copy(digits, digits + n, res.data.data());
+    res.negative = negative;
+    refresh(res);
+    return res;
+}
+
 uint32_t big_integer::get_digit(size_t pos, bool bit) const {
     auto out_of_range = (bit && negative ? UINT32_MAX : 0);
     return (pos >= data.size() ? out_of_range : data[pos]);
@@ -307,6 +834,7 @@ big_integer bit_operation(big_integer a, big_integer const &b, const std::functi
         --res;
     }
 
+    refresh(res);
     return res;
 }
 
@@ -355,9 +883,16 @@ big_integer operator>>(big_integer a, int32_t b) {
     bool reminder_exists = false;
     size_t shift = (size_t) b & (LOG2_BASE - 1), div = (size_t) b / LOG2_BASE;
     uint32_t carry = 0;
+    if (div >= a.data.size()) {
+        return (a.negative ? -1 : 0);
+    }
     for (size_t i = 0; i < a.data.size(); ++i) {
-        reminder_exists = a.data[i] != 0 && div > 0;
-        a.data[i] = a.data[i + div];
+        if (i < div) {
+            reminder_exists |= a.data[i] != 0;
+        }
+        if (i + div < a.data.size()) {
+            a.data[i] = a.data[i + div];
+        }
     }
     a.data.resize(a.data.size() - div);
     for (size_t i = a.data.size() - 1; i != (size_t) (-1); --i) {
@@ -374,6 +909,27 @@ big_integer operator>>(big_integer a, int32_t b) {
     return a;
 }
 
+// Compares a with b given by absolute value and sign: -1, 0 or 1
+int compare_word(big_integer const &a, uint64_t b, bool b_negative) {
+    b_negative &= (b != 0);
+    if (a.negative != b_negative) {
+        return (a.negative ? -1 : 1);
+    }
+
+    int res;
+    if (a.data.size() > 2) {
+        res = 1;
+    } else {
+        uint64_t x = a.data[0];
+        if (a.data.size() == 2) {
+            x |= (uint64_t) a.data[1] << LOG2_BASE;
+        }
+        res = (x < b ? -1 : (x > b ? 1 : 0));
+    }
+
+    return (a.negative ? -res : res);
+}
+
 bool operator==(big_integer const &a, big_integer const &b) {
     return (a.negative == b.negative && a.data == b.data);
 }
@@ -411,22 +967,82 @@ bool operator>=(big_integer const &a, big_integer const &b) {
     return !(a < b);
 }
 
+namespace {
+    // |a| as exactly len decimal digits ending at out + len, leading places are zeros,
+    // nine digits are peeled off per pass over the number
+    void write_basecase(big_integer const &a, char *out, size_t len) {
+        static const divisor_1 chunk(1000000000);
+
+        size_t n = a.digits_qty();
+        std::vector<uint32_t> digits(n);
+        to_digits(a, digits.data(), n);
+        char *pos = out + len;
+        while (n > 0) {
+            uint32_t rem = divrem_1(digits.data(), digits.data(), n, chunk);
+            while (n > 0 && digits[n - 1] == 0) {
+                --n;
+            }
+            for (size_t i = 0; i < 9 && pos != out; ++i) {
+                *--pos = (char) (rem % 10 + '0');
+                rem /= 10;
+            }
+        }
+        std::fill(out, pos, '0');
+    }
+
+    /*
+     * Writes |a| < 10^(9 * 2^k) as exactly 9 * 2^k digits, powers[i] = 10^(9 * 2^i).
+     * The quotient and the remainder by powers[k - 1] are the two halves of the output,
+     * so they are written independently, long ones as parallel tasks.
+     */
+    void write_digits(big_integer const &a, char *out, size_t k, std::vector<big_integer> const &powers, bool parallel) {
+        if (a.digits_qty() < TO_STRING_THRESHOLD) {
+            write_basecase(a, out, (size_t) 9 << k);
+            return;
+        }
+        big_integer q, r;
+        divmod(a, powers[k - 1], q, r);
+        size_t half = (size_t) 9 << (k - 1);
+        if (parallel && a.digits_qty() >= PARALLEL_MUL_THRESHOLD) {
+            task_group group(default_pool());
+            group.spawn([&] { write_digits(q, out, k - 1, powers, parallel); });
+            write_digits(r, out + half, k - 1, powers, parallel);
+            group.wait();
+        } else {
+            write_digits(q, out, k - 1, powers, parallel);
+            write_digits(r, out + half, k - 1, powers, parallel);
+        }
+    }
+}
+
+// Divide and conquer by 10^(9 * 2^k) into a string of the final size, leading zeros are cut at the end
 std::string to_string(big_integer const &a) {
-    if (a == 0) {
-        return "0";
+    big_integer x = a;
+    x.negative = false;
+
+    // |a| has at most bits * log10(2) + 1 digits
+    size_t bits = bit_length(x), len = bits * 30103 / 100000 + 1, k = 0;
+    std::vector<big_integer> powers;
+    if (x.digits_qty() >= TO_STRING_THRESHOLD) {
+        powers.push_back(1000000000);
+        for (k = 1; ((size_t) 9 << k) < len; ++k) {
+            powers.push_back(powers.back() * powers.back());
+        }
+        len = (size_t) 9 << k;
     }
 
-    std::string res;
-    big_integer cpy = a;
-    while (cpy != 0) {
-        res += (char) ((cpy % 10).data[0] + '0');
-        cpy /= 10;
+    std::string res(len + 1, '-');
+    if (k == 0) {
+        write_basecase(x, &res[1], len);
+    } else {
+        write_digits(x, &res[1], k, powers, thread_count() > 1);
     }
 
+    size_t first = std::min(res.find_first_not_of('0', 1), len);
+    res.erase(0, first - (a.negative ? 1 : 0));
     if (a.negative) {
-        res += '-';
+        res[0] = '-';
     }
-    std::reverse(res.begin(), res.end());
     return res;
 }
 
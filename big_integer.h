@@ -2,18 +2,37 @@
 #define BIG_INTEGER_H
 
 #include "opt_vector.h"
+#include "divisor_1.h"
 
 #include <cstddef>
 #include <iosfwd>
 #include <vector>
 #include <cstdint>
 #include <functional>
+#include <string>
+#include <type_traits>
+
+// Return type R for operators taking a machine word of type T
+template <typename T, typename R>
+using enable_if_integral = typename std::enable_if<std::is_integral<T>::value, R>::type;
+
+template <typename T>
+inline bool word_negative(T a) {
+    return std::is_signed<T>::value && a < 0;
+}
+
+template <typename T>
+inline uint64_t word_magnitude(T a) {
+    return word_negative(a) ? 0 - (uint64_t) a : (uint64_t) a;
+}
 
 struct big_integer {
     big_integer();
     big_integer(big_integer const& other);
     big_integer(int32_t a);
     big_integer(uint32_t a);
+    template <typename T, typename = enable_if_integral<T, void>>
+    big_integer(T a);
     explicit big_integer(std::string const& str);
     ~big_integer();
 
@@ -29,6 +48,20 @@ struct big_integer {
     big_integer& operator|=(big_integer const& rhs);
     big_integer& operator^=(big_integer const& rhs);
 
+    // Machine word operands, they work in place without temporaries
+    template <typename T> enable_if_integral<T, big_integer&> operator+=(T rhs);
+    template <typename T> enable_if_integral<T, big_integer&> operator-=(T rhs);
+    template <typename T> enable_if_integral<T, big_integer&> operator*=(T rhs);
+    template <typename T> enable_if_integral<T, big_integer&> operator/=(T rhs);
+    template <typename T> enable_if_integral<T, big_integer&> operator%=(T rhs);
+
+    template <typename T> enable_if_integral<T, big_integer&> operator&=(T rhs);
+    template <typename T> enable_if_integral<T, big_integer&> operator|=(T rhs);
+    template <typename T> enable_if_integral<T, big_integer&> operator^=(T rhs);
+
+    big_integer& operator/=(divisor_1 const& rhs);
+    big_integer& operator%=(divisor_1 const& rhs);
+
     big_integer& operator<<=(int32_t rhs);
     big_integer& operator>>=(int32_t rhs);
 
@@ -49,12 +82,20 @@ struct big_integer {
     friend big_integer operator/(big_integer a, uint32_t b);
     friend big_integer operator/(big_integer a, big_integer const& b);
     friend big_integer operator%(big_integer a, big_integer const& b);
+    friend void divmod(big_integer const& a, big_integer const& b, big_integer& q, big_integer& r);
+    friend big_integer divexact(big_integer const& a, big_integer const& b);
+    friend big_integer divexact_by_uint32(big_integer const& a, uint32_t b);
+    friend big_integer operator/(big_integer a, divisor_1 const& b);
+    friend big_integer operator%(big_integer const& a, divisor_1 const& b);
+    friend big_integer pow(big_integer const& a, uint64_t e);
 
     friend big_integer bit_operation(big_integer a, big_integer const& b, const std::function<uint32_t(uint32_t, uint32_t)> &bit_op);
 
     friend big_integer operator<<(big_integer a, int b);
     friend big_integer operator>>(big_integer a, int b);
 
+    friend int compare_word(big_integer const& a, uint64_t b, bool b_negative);
+
     friend bool operator==(big_integer const& a, big_integer const& b);
     friend bool operator!=(big_integer const& a, big_integer const& b);
     friend bool operator<(big_integer const& a, big_integer const& b);
@@ -68,15 +109,29 @@ struct big_integer {
     uint32_t get_digit(size_t pos, bool bit) const;
     friend void refresh(big_integer &a);
 
-/*
     size_t digits_qty() const;
-    unsigned int get_digit(size_t pos) const;
-     */
+    // Copies absolute value into n digits, n must be at least digits_qty()
+    friend void to_digits(big_integer const& a, uint32_t *res, size_t n);
+    friend big_integer from_digits(uint32_t const *digits, size_t n, bool negative);
 
 private:
     // digit from 0 to 2^32 - 1
     opt_vector<uint32_t> data;
     bool negative;
+
+    big_integer(uint64_t magnitude, bool negative);
+
+    // b is given by its absolute value and sign
+    big_integer& add_word(uint64_t b, bool b_negative);
+    big_integer& mul_word(uint64_t b, bool b_negative);
+    big_integer& div_word(uint64_t b, bool b_negative);
+    big_integer& mod_word(uint64_t b);
+    big_integer& and_word(uint64_t b, bool b_negative);
+    big_integer& or_word(uint64_t b, bool b_negative);
+    big_integer& xor_word(uint64_t b, bool b_negative);
+
+    template <typename Op>
+    big_integer& bit_word(uint64_t b, bool b_negative, Op bit_op);
 };
 
 big_integer operator+(big_integer a, big_integer const& b);
@@ -86,6 +141,16 @@ big_integer operator/(big_integer a, int32_t b);
 big_integer operator/(big_integer a, uint32_t b);
 big_integer operator/(big_integer a, big_integer const& b);
 big_integer operator%(big_integer a, big_integer const& b);
+// q = a / b and r = a % b at once, rounding is the same as in / and %
+void divmod(big_integer const& a, big_integer const& b, big_integer& q, big_integer& r);
+// a / b when b is known to divide a, much faster than the division with remainder
+big_integer divexact(big_integer const& a, big_integer const& b);
+big_integer divexact_by_uint32(big_integer const& a, uint32_t b);
+big_integer operator/(big_integer a, divisor_1 const& b);
+big_integer operator%(big_integer const& a, divisor_1 const& b);
+// Power with non-negative exponent, pow(0, 0) = 1,
+// throws std::length_error if the result can not be allocated in one piece
+big_integer pow(big_integer const& a, uint64_t e);
 
 big_integer operator&(big_integer a, big_integer const& b);
 big_integer operator|(big_integer a, big_integer const& b);
@@ -101,9 +166,187 @@ bool operator>(big_integer const& a, big_integer const& b);
 bool operator<=(big_integer const& a, big_integer const& b);
 bool operator>=(big_integer const& a, big_integer const& b);
 
+int compare_word(big_integer const& a, uint64_t b, bool b_negative);
+
 std::string to_string(big_integer const& a);
 std::ostream& operator<<(std::ostream& s, big_integer const& a);
 
 big_integer bit_inverse(big_integer a);
 
+void to_digits(big_integer const& a, uint32_t *res, size_t n);
+big_integer from_digits(uint32_t const *digits, size_t n, bool negative = false);
+
+template <typename T, typename U>
+big_integer::big_integer(T a) : big_integer(word_magnitude(a), word_negative(a)) {}
+
+template <typename T>
+enable_if_integral<T, big_integer&> big_integer::operator+=(T rhs) {
+    return add_word(word_magnitude(rhs), word_negative(rhs));
+}
+
+template <typename T>
+enable_if_integral<T, big_integer&> big_integer::operator-=(T rhs) {
+    return add_word(word_magnitude(rhs), !word_negative(rhs));
+}
+
+template <typename T>
+enable_if_integral<T, big_integer&> big_integer::operator*=(T rhs) {
+    return mul_word(word_magnitude(rhs), word_negative(rhs));
+}
+
+template <typename T>
+enable_if_integral<T, big_integer&> big_integer::operator/=(T rhs) {
+    return div_word(word_magnitude(rhs), word_negative(rhs));
+}
+
+template <typename T>
+enable_if_integral<T, big_integer&> big_integer::operator%=(T rhs) {
+    return mod_word(word_magnitude(rhs));
+}
+
+template <typename T>
+enable_if_integral<T, big_integer&> big_integer::operator&=(T rhs) {
+    return and_word(word_magnitude(rhs), word_negative(rhs));
+}
+
+template <typename T>
+enable_if_integral<T, big_integer&> big_integer::operator|=(T rhs) {
+    return or_word(word_magnitude(rhs), word_negative(rhs));
+}
+
+template <typename T>
+enable_if_integral<T, big_integer&> big_integer::operator^=(T rhs) {
+    return xor_word(word_magnitude(rhs), word_negative(rhs));
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator+(big_integer a, T b) {
+    return a += b;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator+(T a, big_integer b) {
+    return b += a;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator-(big_integer a, T b) {
+    return a -= b;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator-(T a, big_integer b) {
+    return -(b -= a);
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator*(big_integer a, T b) {
+    return a *= b;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator*(T a, big_integer b) {
+    return b *= a;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator/(big_integer a, T b) {
+    return a /= b;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator%(big_integer a, T b) {
+    return a %= b;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator&(big_integer a, T b) {
+    return a &= b;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator&(T a, big_integer b) {
+    return b &= a;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator|(big_integer a, T b) {
+    return a |= b;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator|(T a, big_integer b) {
+    return b |= a;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator^(big_integer a, T b) {
+    return a ^= b;
+}
+
+template <typename T>
+enable_if_integral<T, big_integer> operator^(T a, big_integer b) {
+    return b ^= a;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator==(big_integer const& a, T b) {
+    return compare_word(a, word_magnitude(b), word_negative(b)) == 0;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator!=(big_integer const& a, T b) {
+    return compare_word(a, word_magnitude(b), word_negative(b)) != 0;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator<(big_integer const& a, T b) {
+    return compare_word(a, word_magnitude(b), word_negative(b)) < 0;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator>(big_integer const& a, T b) {
+    return compare_word(a, word_magnitude(b), word_negative(b)) > 0;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator<=(big_integer const& a, T b) {
+    return compare_word(a, word_magnitude(b), word_negative(b)) <= 0;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator>=(big_integer const& a, T b) {
+    return compare_word(a, word_magnitude(b), word_negative(b)) >= 0;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator==(T a, big_integer const& b) {
+    return b == a;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator!=(T a, big_integer const& b) {
+    return b != a;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator<(T a, big_integer const& b) {
+    return b > a;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator>(T a, big_integer const& b) {
+    return b < a;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator<=(T a, big_integer const& b) {
+    return b >= a;
+}
+
+template <typename T>
+enable_if_integral<T, bool> operator>=(T a, big_integer const& b) {
+    return b <= a;
+}
+
 #endif // BIG_INTEGER_H
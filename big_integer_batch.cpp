@@ -0,0 +1,262 @@
+#include "big_integer_batch.h"
+
+#include <algorithm>
+#include <assert.h>
+
+const uint32_t LOG2_BASE = 32;
+// Lanes are processed in blocks of this size, so that their carries stay in L1 cache
+const size_t BATCH_BLOCK = 256;
+
+/*
+ * Lane loops are compiled for AVX-512, AVX2 and the baseline instruction set,
+ * the dynamic loader picks the best one for the running CPU. Other compilers
+ * get the baseline loops, which are still vectorized for SSE2.
+ */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define BATCH_SIMD __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define BATCH_SIMD
+#endif
+
+// Every kernel works over n <= BATCH_BLOCK lanes, rows are stride digits apart
+
+BATCH_SIMD
+static void add_lanes(uint32_t *r, uint32_t const *a, uint32_t const *b, size_t width, size_t n, size_t stride) {
+    uint32_t carry[BATCH_BLOCK] = {};
+    for (size_t i = 0; i < width; ++i) {
+        uint32_t *ri = r + i * stride;
+        uint32_t const *ai = a + i * stride, *bi = b + i * stride;
+        for (size_t l = 0; l < n; ++l) {
+            uint64_t sum = (uint64_t) ai[l] + bi[l] + carry[l];
+            ri[l] = (uint32_t) sum;
+            carry[l] = (uint32_t) (sum >> LOG2_BASE);
+        }
+    }
+}
+
+BATCH_SIMD
+static void sub_lanes(uint32_t *r, uint32_t const *a, uint32_t const *b, size_t width, size_t n, size_t stride) {
+    uint32_t borrow[BATCH_BLOCK] = {};
+    for (size_t i = 0; i < width; ++i) {
+        uint32_t *ri = r + i * stride;
+        uint32_t const *ai = a + i * stride, *bi = b + i * stride;
+        for (size_t l = 0; l < n; ++l) {
+            uint64_t difference = (uint64_t) ai[l] - bi[l] - borrow[l];
+            ri[l] = (uint32_t) difference;
+            borrow[l] = (uint32_t) (difference >> (LOG2_BASE * 2 - 1));
+        }
+    }
+}
+
+// Schoolbook product of every lane, r has wa + wb rows and must not overlap a or b
+BATCH_SIMD
+static void mul_lanes(uint32_t *r, uint32_t const *a, size_t wa, uint32_t const *b, size_t wb, size_t n,
+                      size_t stride) {
+    uint64_t carry[BATCH_BLOCK];
+    for (size_t i = 0; i < wa + wb; ++i) {
+        std::fill(r + i * stride, r + i * stride + n, 0);
+    }
+    for (size_t i = 0; i < wa; ++i) {
+        std::fill(carry, carry + n, 0);
+        uint32_t const *ai = a + i * stride;
+        for (size_t j = 0; j < wb; ++j) {
+            uint32_t *rij = r + (i + j) * stride;
+            uint32_t const *bj = b + j * stride;
+            for (size_t l = 0; l < n; ++l) {
+                uint64_t t = (uint64_t) ai[l] * bj[l] + rij[l] + carry[l];
+                rij[l] = (uint32_t) t;
+                carry[l] = t >> LOG2_BASE;
+            }
+        }
+        uint32_t *top = r + (i + wb) * stride;
+        for (size_t l = 0; l < n; ++l) {
+            top[l] = (uint32_t) carry[l];
+        }
+    }
+}
+
+// Higher digits decide, so going up every difference overrides the previous one
+BATCH_SIMD
+static void compare_lanes(int *res, uint32_t const *a, uint32_t const *b, size_t width, size_t n, size_t stride) {
+    std::fill(res, res + n, 0);
+    for (size_t i = 0; i < width; ++i) {
+        uint32_t const *ai = a + i * stride, *bi = b + i * stride;
+        for (size_t l = 0; l < n; ++l) {
+            res[l] = ai[l] > bi[l] ? 1 : (ai[l] < bi[l] ? -1 : res[l]);
+        }
+    }
+}
+
+// Row i of r takes the bits of rows i - shift and i - shift - 1 of a, r must not overlap a
+BATCH_SIMD
+static void lshift_lanes(uint32_t *r, uint32_t const *a, size_t width, size_t n, size_t stride, size_t shift,
+                         uint32_t cnt) {
+    for (size_t i = 0; i < width; ++i) {
+        uint32_t *ri = r + i * stride;
+        if (i < shift) {
+            std::fill(ri, ri + n, 0);
+            continue;
+        }
+        uint32_t const *cur = a + (i - shift) * stride;
+        if (cnt == 0 || i == shift) {
+            for (size_t l = 0; l < n; ++l) {
+                ri[l] = cur[l] << cnt;
+            }
+        } else {
+            uint32_t const *prev = cur - stride;
+            for (size_t l = 0; l < n; ++l) {
+                ri[l] = (cur[l] << cnt) | (prev[l] >> (LOG2_BASE - cnt));
+            }
+        }
+    }
+}
+
+// Row i of r takes the bits of rows i + shift and i + shift + 1 of a, r must not overlap a
+BATCH_SIMD
+static void rshift_lanes(uint32_t *r, uint32_t const *a, size_t width, size_t n, size_t stride, size_t shift,
+                         uint32_t cnt) {
+    for (size_t i = 0; i < width; ++i) {
+        uint32_t *ri = r + i * stride;
+        if (i + shift >= width) {
+            std::fill(ri, ri + n, 0);
+            continue;
+        }
+        uint32_t const *cur = a + (i + shift) * stride;
+        if (cnt == 0 || i + shift + 1 == width) {
+            for (size_t l = 0; l < n; ++l) {
+                ri[l] = cur[l] >> cnt;
+            }
+        } else {
+            uint32_t const *next = cur + stride;
+            for (size_t l = 0; l < n; ++l) {
+                ri[l] = (cur[l] >> cnt) | (next[l] << (LOG2_BASE - cnt));
+            }
+        }
+    }
+}
+
+big_integer_batch::big_integer_batch(size_t size, size_t width) : lanes(size), digits(width), data(size * width) {
+    assert (width > 0);
+}
+
+big_integer_batch::big_integer_batch(std::vector<big_integer> const &values, size_t width)
+    : big_integer_batch(values.size(), width) {
+    for (size_t l = 0; l < lanes; ++l) {
+        set(l, values[l]);
+    }
+}
+
+std::vector<big_integer> big_integer_batch::to_vector() const {
+    std::vector<big_integer> res(lanes);
+    for (size_t l = 0; l < lanes; ++l) {
+        res[l] = get(l);
+    }
+    return res;
+}
+
+big_integer big_integer_batch::get(size_t lane) const {
+    assert (lane < lanes);
+    std::vector<uint32_t> value(digits);
+    for (size_t i = 0; i < digits; ++i) {
+        value[i] = data[i * lanes + lane];
+    }
+    return from_digits(value.data(), digits);
+}
+
+void big_integer_batch::set(size_t lane, big_integer const &value) {
+    assert (lane < lanes && value >= 0 && value.digits_qty() <= digits);
+    std::vector<uint32_t> digits_of(digits);
+    to_digits(value, digits_of.data(), digits);
+    for (size_t i = 0; i < digits; ++i) {
+        data[i * lanes + lane] = digits_of[i];
+    }
+}
+
+size_t big_integer_batch::size() const {
+    return lanes;
+}
+
+size_t big_integer_batch::width() const {
+    return digits;
+}
+
+uint32_t *big_integer_batch::row(size_t i) {
+    return data.data() + i * lanes;
+}
+
+uint32_t const *big_integer_batch::row(size_t i) const {
+    return data.data() + i * lanes;
+}
+
+big_integer_batch &big_integer_batch::operator+=(big_integer_batch const &rhs) {
+    assert (lanes == rhs.lanes && digits == rhs.digits);
+    for (size_t l = 0; l < lanes; l += BATCH_BLOCK) {
+        add_lanes(row(0) + l, row(0) + l, rhs.row(0) + l, digits, std::min(BATCH_BLOCK, lanes - l), lanes);
+    }
+    return *this;
+}
+
+big_integer_batch &big_integer_batch::operator-=(big_integer_batch const &rhs) {
+    assert (lanes == rhs.lanes && digits == rhs.digits);
+    for (size_t l = 0; l < lanes; l += BATCH_BLOCK) {
+        sub_lanes(row(0) + l, row(0) + l, rhs.row(0) + l, digits, std::min(BATCH_BLOCK, lanes - l), lanes);
+    }
+    return *this;
+}
+
+big_integer_batch operator+(big_integer_batch a, big_integer_batch const &b) {
+    return a += b;
+}
+
+big_integer_batch operator-(big_integer_batch a, big_integer_batch const &b) {
+    return a -= b;
+}
+
+big_integer_batch operator*(big_integer_batch const &a, big_integer_batch const &b) {
+    assert (a.lanes == b.lanes);
+    big_integer_batch res(a.lanes, a.digits + b.digits);
+    for (size_t l = 0; l < a.lanes; l += BATCH_BLOCK) {
+        mul_lanes(res.row(0) + l, a.row(0) + l, a.digits, b.row(0) + l, b.digits,
+                  std::min(BATCH_BLOCK, a.lanes - l), a.lanes);
+    }
+    return res;
+}
+
+big_integer_batch operator<<(big_integer_batch const &a, uint32_t bits) {
+    big_integer_batch res(a.lanes, a.digits);
+    for (size_t l = 0; l < a.lanes; l += BATCH_BLOCK) {
+        lshift_lanes(res.row(0) + l, a.row(0) + l, a.digits, std::min(BATCH_BLOCK, a.lanes - l), a.lanes,
+                     bits / LOG2_BASE, bits % LOG2_BASE);
+    }
+    return res;
+}
+
+big_integer_batch operator>>(big_integer_batch const &a, uint32_t bits) {
+    big_integer_batch res(a.lanes, a.digits);
+    for (size_t l = 0; l < a.lanes; l += BATCH_BLOCK) {
+        rshift_lanes(res.row(0) + l, a.row(0) + l, a.digits, std::min(BATCH_BLOCK, a.lanes - l), a.lanes,
+                     bits / LOG2_BASE, bits % LOG2_BASE);
+    }
+    return res;
+}
+
+std::vector<int> compare(big_integer_batch const &a, big_integer_batch const &b) {
+    assert (a.lanes == b.lanes);
+    std::vector<int> res(a.lanes);
+    size_t common = std::min(a.digits, b.digits);
+    for (size_t l = 0; l < a.lanes; l += BATCH_BLOCK) {
+        compare_lanes(res.data() + l, a.row(0) + l, b.row(0) + l, common, std::min(BATCH_BLOCK, a.lanes - l),
+                      a.lanes);
+    }
+    // Digits above the common width decide if they are not zero
+    for (size_t l = 0; l < a.lanes; ++l) {
+        for (size_t i = common; i < std::max(a.digits, b.digits); ++i) {
+            if (i < a.digits && a.row(i)[l] != 0) {
+                res[l] = 1;
+            } else if (i < b.digits && b.row(i)[l] != 0) {
+                res[l] = -1;
+            }
+        }
+    }
+    return res;
+}
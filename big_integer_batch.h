@@ -0,0 +1,58 @@
+#ifndef BIGINT_BIG_INTEGER_BATCH_H
+#define BIGINT_BIG_INTEGER_BATCH_H
+
+#include "big_integer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Many non-negative values of the same number of digits in
+ * structure-of-arrays layout: digit i of every value lies in row i,
+ * so an operation is a loop over rows with an inner loop over values
+ * (lanes) that the compiler turns into vector instructions.
+ *
+ * Sums, differences and shifts wrap modulo 2^(32 * width) like machine
+ * words do, products are full and have the width of both operands.
+ * Operands of a lane-wise operation must have equal size, sums and
+ * differences also equal width.
+ */
+struct big_integer_batch {
+    big_integer_batch(size_t size, size_t width);
+    // Every value must be non-negative and fit into width digits
+    big_integer_batch(std::vector<big_integer> const& values, size_t width);
+
+    std::vector<big_integer> to_vector() const;
+    big_integer get(size_t lane) const;
+    void set(size_t lane, big_integer const& value);
+
+    size_t size() const;
+    size_t width() const;
+    // Digit i of every lane
+    uint32_t *row(size_t i);
+    uint32_t const *row(size_t i) const;
+
+    big_integer_batch& operator+=(big_integer_batch const& rhs);
+    big_integer_batch& operator-=(big_integer_batch const& rhs);
+
+    friend big_integer_batch operator*(big_integer_batch const& a, big_integer_batch const& b);
+    friend big_integer_batch operator<<(big_integer_batch const& a, uint32_t bits);
+    friend big_integer_batch operator>>(big_integer_batch const& a, uint32_t bits);
+    // -1, 0 or 1 for every lane
+    friend std::vector<int> compare(big_integer_batch const& a, big_integer_batch const& b);
+
+private:
+    size_t lanes;
+    size_t digits;
+    std::vector<uint32_t> data;
+};
+
+big_integer_batch operator+(big_integer_batch a, big_integer_batch const& b);
+big_integer_batch operator-(big_integer_batch a, big_integer_batch const& b);
+big_integer_batch operator*(big_integer_batch const& a, big_integer_batch const& b);
+big_integer_batch operator<<(big_integer_batch const& a, uint32_t bits);
+big_integer_batch operator>>(big_integer_batch const& a, uint32_t bits);
+std::vector<int> compare(big_integer_batch const& a, big_integer_batch const& b);
+
+#endif //BIGINT_BIG_INTEGER_BATCH_H
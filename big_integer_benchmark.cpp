@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <numeric>
+#include <iostream>
+#include <thread>
+
+#include "big_integer.h"
+#include "number_theory.h"
+#include "product_tree.h"
+#include "crt.h"
+#include "thread_pool.h"
+#include "big_integer_batch.h"
+#include "reduction.h"
+#include "matrix.h"
+#include "serialization.h"
+
+namespace
+{
+    big_integer rand_bits(size_t bits)
+    {
+        big_integer result = 1;
+        for (size_t i = 1; i != bits; ++i)
+            result = (result << 1) + (rand() & 1);
+        return result;
+    }
+
+    template <typename F>
+    void measure(char const* name, size_t iterations, F f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i != iterations; ++i)
+            f();
+        auto finish = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(finish - start).count();
+        std::cout << name << ": " << ms / iterations << " ms" << std::endl;
+    }
+}
+
+int main()
+{
+    for (size_t bits : {2048, 4096})
+    {
+        big_integer m = rand_bits(bits) | 1;
+        big_integer base = rand_bits(bits - 1);
+        big_integer d = rand_bits(bits - 1);
+        big_integer e = 65537;
+        std::string size = "RSA-" + std::to_string(bits);
+
+        measure((size + " public pow_mod").c_str(), 100, [&] { pow_mod(base, e, m); });
+        measure((size + " private pow_mod").c_str(), 5, [&] { pow_mod(base, d, m); });
+        measure((size + " private pow_mod_sec").c_str(), 5, [&] { pow_mod_sec(base, d, m); });
+        measure((size + " even modulus pow_mod").c_str(), 5, [&] { pow_mod(base, d, m + 1); });
+        big_integer inv;
+        measure((size + " inverse_mod").c_str(), 100, [&] { inverse_mod(base, m, inv); });
+        measure((size + " jacobi").c_str(), 100, [&] { jacobi(base, m); });
+        big_integer p = next_prime(base);
+        measure((size + " next_prime").c_str(), 1, [&] { next_prime(base); });
+        measure((size + " is_probable_prime").c_str(), 5, [&] { is_probable_prime(p); });
+        big_integer u, v;
+        measure((size + " lucas_sequence").c_str(), 5, [&] { lucas_sequence(1, -1, d, m, u, v); });
+    }
+
+    for (size_t bits : {3200, 32000, 160000})
+    {
+        big_integer a = rand_bits(bits), b = rand_bits(bits);
+        std::string size = std::to_string(bits) + " bits";
+
+        measure((size + " mul").c_str(), 5, [&] { a * b; });
+        measure((size + " isqrt").c_str(), 5, [&] { isqrt(a); });
+        measure((size + " cube root").c_str(), 5, [&] { iroot(a, 3); });
+    }
+
+    for (size_t bits : {3200, 32000, 160000})
+    {
+        big_integer a = rand_bits(bits), b = rand_bits(bits);
+        big_integer s, t;
+        std::string size = std::to_string(bits) + " bits";
+
+        measure((size + " gcd").c_str(), 5, [&] { gcd(a, b); });
+        measure((size + " gcdext").c_str(), 5, [&] { gcdext(a, b, s, t); });
+    }
+
+    measure("factorial(100000)", 1, [] { factorial(100000); });
+    measure("binomial(200000, 100000)", 1, [] { binomial(200000, 100000); });
+    measure("fibonacci(10000000)", 1, [] { fibonacci(10000000); });
+    measure("fibonacci(100000) by additions", 1, [] {
+        big_integer f = 0, g = 1;
+        for (size_t i = 0; i != 100000; ++i)
+        {
+            std::swap(f, g);
+            g += f;
+        }
+    });
+
+    for (size_t bits : {32, 1024})
+    {
+        std::vector<big_integer> moduli;
+        for (size_t i = 0; i != 1000; ++i)
+            moduli.push_back(rand_bits(bits));
+        subproduct_tree tree = product_tree(moduli);
+        big_integer x = tree.product() / rand_bits(64);
+        std::string size = "1000 x " + std::to_string(bits) + " bits";
+
+        measure((size + " product_tree").c_str(), 1, [&] { product_tree(moduli); });
+        measure((size + " remainder_tree").c_str(), 1, [&] { remainder_tree(x, tree); });
+        measure((size + " remainders one by one").c_str(), 1, [&] {
+            for (big_integer const& m : moduli)
+                x % m;
+        });
+    }
+
+    std::vector<uint32_t> primes, residues;
+    for (uint32_t m = 4294967291u; primes.size() != 2000; m -= 2)
+        if (is_probable_prime(m))
+        {
+            primes.push_back(m);
+            residues.push_back(rand() % m);
+        }
+    measure("2000 word primes crt_context", 1, [&] { crt_context ctx(primes); });
+    crt_context ctx(primes);
+    measure("2000 word primes reconstruct", 10, [&] { ctx.reconstruct(residues); });
+
+    std::vector<big_integer> xs, ys;
+    for (size_t i = 0; i != 1000000; ++i)
+    {
+        uint32_t words[8];
+        for (uint32_t& word : words)
+            word = (uint32_t) rand() * 2 + (rand() & 1);
+        xs.push_back(from_digits(words, 4));
+        ys.push_back(from_digits(words + 4, 4));
+    }
+    big_integer_batch a(xs, 4), b(ys, 4);
+    measure("1000000 x 128 bits add one by one", 1, [&] {
+        for (size_t i = 0; i != xs.size(); ++i)
+            xs[i] + ys[i];
+    });
+    measure("1000000 x 128 bits batch add", 10, [&] { a += b; });
+    measure("1000000 x 128 bits mul one by one", 1, [&] {
+        for (size_t i = 0; i != xs.size(); ++i)
+            xs[i] * ys[i];
+    });
+    measure("1000000 x 128 bits batch mul", 10, [&] { a * b; });
+
+    std::vector<uint32_t> digits(200000);
+    for (uint32_t& digit : digits)
+        digit = (uint32_t) rand() * 2 + (rand() & 1);
+    big_integer x = from_digits(digits.data(), 100000), y = from_digits(digits.data() + 100000, 100000);
+    std::vector<big_integer> terms;
+    for (size_t i = 0; i != 1000000; ++i)
+        terms.push_back(from_digits(&digits[i % 199990], 1 + i % 8));
+    measure("1000000 terms accumulate", 1, [&] { std::accumulate(terms.begin(), terms.end(), big_integer(0)); });
+    measure("1000000 terms sum", 1, [&] { sum(terms.begin(), terms.end()); });
+    std::vector<big_integer> row(terms.begin(), terms.begin() + 500000), column(terms.begin() + 500000, terms.end());
+    measure("500000 terms acc += a * b", 1, [&] {
+        big_integer acc = 0;
+        for (size_t i = 0; i != row.size(); ++i)
+            acc += row[i] * column[i];
+    });
+    measure("500000 terms dot", 1, [&] { dot(row, column); });
+    big_integer_matrix left(100, 100), right(100, 100), square(60, 60);
+    for (size_t i = 0; i != 10000; ++i)
+    {
+        left(i / 100, i % 100) = terms[i];
+        right(i / 100, i % 100) = terms[10000 + i];
+    }
+    for (size_t i = 0; i != 3600; ++i)
+        square(i / 60, i % 60) = i % 2 ? terms[20000 + i] % 1000000007 : -(terms[20000 + i] % 1000000007);
+    measure("100 x 100 matrix product, naive", 1, [&] {
+        big_integer_matrix res(100, 100);
+        for (size_t i = 0; i != 100; ++i)
+            for (size_t j = 0; j != 100; ++j)
+                for (size_t k = 0; k != 100; ++k)
+                    res(i, j) += left(i, k) * right(k, j);
+    });
+    measure("100 x 100 matrix product", 1, [&] { left * right; });
+    measure("60 x 60 determinant, Bareiss", 1, [&] { determinant(square); });
+    measure("60 x 60 determinant, multimodular", 1, [&] { determinant_multimodular(square); });
+    for (size_t size : {100, 2000})
+    {
+        big_integer divisor = from_digits(digits.data(), size), quotient = from_digits(digits.data() + size, size);
+        big_integer dividend = divisor * quotient;
+        std::string name = std::to_string(2 * size) + " digits by " + std::to_string(size);
+        measure((name + " operator/").c_str(), 10, [&] { dividend / divisor; });
+        measure((name + " divexact").c_str(), 10, [&] { divexact(dividend, divisor); });
+    }
+    std::vector<big_integer> factors(terms.begin(), terms.begin() + 5000);
+    measure("5000 factors accumulate", 1, [&] {
+        std::accumulate(factors.begin(), factors.end(), big_integer(1), std::multiplies<big_integer>());
+    });
+    measure("5000 factors product", 1, [&] { product(factors.begin(), factors.end()); });
+    std::string decimal = to_string(x);
+    std::vector<big_integer> stream;
+    for (size_t i = 0; i != 1000000; ++i)
+        stream.push_back(i % 1000 == 0 ? terms[i] : big_integer((int64_t) rand() % (1 << (rand() % 30)) - rand() % 2));
+    std::vector<uint8_t> varints;
+    measure("1000000 small values to_string", 1, [&] {
+        for (big_integer const& value : stream)
+            to_string(value);
+    });
+    measure("1000000 small values encode_varints", 1, [&] {
+        varints.clear();
+        encode_varints(stream, varints);
+    });
+    measure("1000000 small values decode_varints", 1, [&] {
+        std::vector<big_integer> decoded;
+        decode_varints(varints.data(), varints.size(), decoded);
+    });
+    std::vector<uint8_t> binary;
+    measure("100000 digits serialize", 10, [&] {
+        binary.clear();
+        serialize(x, binary);
+    });
+    measure("100000 digits deserialize", 10, [&] {
+        big_integer loaded;
+        deserialize(binary.data(), binary.size(), loaded);
+    });
+    size_t max_threads = std::max(4u, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        set_thread_count(threads);
+        std::string size = "100000 digits mul, " + std::to_string(threads) + " threads";
+        measure(size.c_str(), 3, [&] { x * y; });
+        size = "100000 digits to_string, " + std::to_string(threads) + " threads";
+        measure(size.c_str(), 1, [&] { to_string(x); });
+        size = "100000 digits from string, " + std::to_string(threads) + " threads";
+        measure(size.c_str(), 1, [&] { big_integer parsed(decimal); });
+    }
+    set_thread_count(1);
+}
@@ -1,11 +1,24 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdio>
 #include <cstdlib>
+#include <stdexcept>
 #include <vector>
 #include <utility>
 #include <gtest/gtest.h>
 
 #include "big_integer.h"
+#include "montgomery.h"
+#include "barrett.h"
+#include "number_theory.h"
+#include "product_tree.h"
+#include "crt.h"
+#include "thread_pool.h"
+#include "big_integer_batch.h"
+#include "reduction.h"
+#include "matrix.h"
+#include "serialization.h"
 
 TEST(correctness, two_plus_two)
 {
@@ -735,3 +748,1062 @@ TEST(correctness, div_randomized)
         EXPECT_LT(residue, divisor);
     }
 }
+
+TEST(correctness, word_operands)
+{
+    big_integer a("123456789012345678901234567890");
+    int64_t b = -9876543210123LL;
+    uint64_t c = 18446744073709551557ULL;
+
+    EXPECT_EQ(a + b, a + big_integer(b));
+    EXPECT_EQ(a - c, a - big_integer(c));
+    EXPECT_EQ(b - a, big_integer(b) - a);
+    EXPECT_EQ(a * b, a * big_integer(b));
+    EXPECT_EQ(a * c, a * big_integer(c));
+    EXPECT_EQ(a / b, a / big_integer(b));
+    EXPECT_EQ(-a / 7u, -a / big_integer(7));
+    EXPECT_EQ(-a % 7, -a % big_integer(7));
+    EXPECT_EQ(a % c, a % big_integer(c));
+    EXPECT_EQ(-a & b, -a & big_integer(b));
+    EXPECT_EQ(a | b, a | big_integer(b));
+    EXPECT_EQ(-a ^ c, -a ^ big_integer(c));
+    EXPECT_EQ(big_integer(-5) & -8, -8);
+    EXPECT_EQ(big_integer(-4294967296LL) | -4294967296LL, -4294967296LL);
+}
+
+TEST(correctness, word_comparisons)
+{
+    big_integer a = -4294967296LL;
+
+    EXPECT_TRUE(a == -4294967296LL);
+    EXPECT_TRUE(a < -4294967295LL);
+    EXPECT_TRUE(a > INT64_MIN);
+    EXPECT_TRUE(0u > a);
+    EXPECT_TRUE(big_integer(UINT64_MAX) == UINT64_MAX);
+    EXPECT_TRUE(big_integer(UINT64_MAX) + 1 > UINT64_MAX);
+    EXPECT_FALSE(big_integer(0) < 0);
+}
+
+TEST(correctness, word_randomized)
+{
+    for (size_t itn = 0; itn != number_of_iterations * number_of_multipliers; ++itn)
+    {
+        big_integer a = rand_big(rand() % 4);
+        if (rand() % 2)
+            a = -a;
+        int64_t b = (int64_t) myrand() * ((int64_t) 1 << (rand() % 32)) + myrand();
+        if (b == 0)
+            b = 1;
+
+        ASSERT_EQ(a + b, a + big_integer(b));
+        ASSERT_EQ(a - b, a - big_integer(b));
+        ASSERT_EQ(a * b, a * big_integer(b));
+        ASSERT_EQ(a / b, a / big_integer(b));
+        ASSERT_EQ(a % b, a % big_integer(b));
+        ASSERT_EQ(a & b, a & big_integer(b));
+        ASSERT_EQ(a | b, a | big_integer(b));
+        ASSERT_EQ(a ^ b, a ^ big_integer(b));
+        ASSERT_EQ(a < b, a < big_integer(b));
+        ASSERT_EQ(a == b, a == big_integer(b));
+    }
+}
+
+TEST(correctness, divisor_1)
+{
+    for (size_t itn = 0; itn != number_of_iterations * number_of_multipliers; ++itn)
+    {
+        big_integer a = rand_big(rand() % 8);
+        if (rand() % 2)
+            a = -a;
+        uint32_t d = (uint32_t) rand() >> (rand() % 31);
+        if (itn % 3 == 0)
+            d |= 0x80000000u;
+        if (d == 0)
+            d = 1;
+
+        divisor_1 inv(d);
+        ASSERT_EQ(a / inv, a / big_integer(d));
+        ASSERT_EQ(a % inv, a % big_integer(d));
+    }
+}
+
+TEST(correctness, string_conv_long)
+{
+    std::string s = "-1";
+    for (size_t i = 0; i != 200; ++i)
+        s += (char) ('0' + (i * 7) % 10);
+    s += "000000000";
+
+    EXPECT_EQ(to_string(big_integer(s)), s);
+    EXPECT_EQ(to_string(big_integer("4294967296")), "4294967296");
+    EXPECT_EQ(to_string(big_integer("1000000000")), "1000000000");
+}
+
+TEST(correctness, montgomery_mul)
+{
+    big_integer m("170141183460469231731687303715884105727");
+    montgomery_context ctx(m);
+
+    for (size_t itn = 0; itn != number_of_multipliers; ++itn)
+    {
+        big_integer a = rand_big(rand() % 6) % m;
+        big_integer b = rand_big(rand() % 6) % m;
+        big_integer x = ctx.to_montgomery(a), y = ctx.to_montgomery(b);
+
+        ASSERT_EQ(ctx.from_montgomery(x), a);
+        ASSERT_EQ(ctx.from_montgomery(ctx.mul(x, y)), a * b % m);
+        ASSERT_EQ(ctx.from_montgomery(ctx.sqr(x)), a * a % m);
+    }
+}
+
+TEST(correctness, montgomery_pow)
+{
+    // 2^127 - 1 is prime
+    big_integer p = (big_integer(1) << 127) - 1;
+    montgomery_context ctx(p);
+    big_integer one = ctx.to_montgomery(1);
+
+    EXPECT_EQ(ctx.pow(ctx.to_montgomery(3), p - 1), one);
+    EXPECT_EQ(ctx.pow(ctx.to_montgomery(-5), p - 1), one);
+    EXPECT_EQ(ctx.from_montgomery(ctx.pow(ctx.to_montgomery(7), 0)), 1);
+    EXPECT_EQ(ctx.from_montgomery(ctx.pow(ctx.to_montgomery(2), 127)), 1);
+
+    montgomery_context small(1000001);
+    big_integer x = 1;
+    for (int i = 0; i != 100; ++i)
+        x = x * 12345 % 1000001;
+    EXPECT_EQ(small.from_montgomery(small.pow(small.to_montgomery(12345), 100)), x);
+}
+
+TEST(correctness, barrett_reduce)
+{
+    for (size_t itn = 0; itn != number_of_multipliers; ++itn)
+    {
+        big_integer m = rand_big(rand() % 5) + 1;
+        if (itn % 10 == 0)
+            m = big_integer(1) << (int) (32 * (itn % 4));
+        barrett_context ctx(m);
+
+        big_integer x = rand_big(rand() % 20);
+        if (rand() % 2)
+            x = -x;
+        big_integer r = x % m;
+        if (r < 0)
+            r += m;
+
+        ASSERT_EQ(ctx.reduce(x), r);
+    }
+}
+
+TEST(correctness, barrett_pow)
+{
+    big_integer m("1000000000000000000000000000000");
+    barrett_context ctx(m);
+
+    std::vector<big_integer> values;
+    big_integer x = 1;
+    for (int i = 0; i != 50; ++i)
+    {
+        values.push_back(x * 3);
+        x = x * 3 % m;
+    }
+    EXPECT_EQ(ctx.pow(3, 50), x);
+    EXPECT_EQ(ctx.pow(3, 0), 1);
+
+    ctx.reduce_many(values);
+    EXPECT_EQ(values.back(), x);
+    EXPECT_EQ(values[0], 3);
+    EXPECT_EQ(ctx.mul(values[1], values[2]), 243);
+}
+
+TEST(correctness, pow_mod)
+{
+    big_integer p("115792089237316195423570985008687907853269984665640564039457584007908834671663");
+
+    EXPECT_EQ(pow_mod(2, p - 1, p), 1);
+    EXPECT_EQ(pow_mod(-3, p - 1, p), 1);
+    EXPECT_EQ(pow_mod(5, 0, p), 1);
+    EXPECT_EQ(pow_mod(5, 3, 1), 0);
+    EXPECT_EQ(pow_mod_sec(2, p - 1, p), 1);
+    EXPECT_EQ(pow_mod(-2, 3, 10), 2);
+
+    for (size_t itn = 0; itn != 100; ++itn)
+    {
+        big_integer m = rand_big(rand() % 8) + 2;
+        big_integer a = rand_big(rand() % 8);
+        unsigned e = rand() % 300;
+
+        big_integer expected = 1;
+        for (unsigned i = 0; i != e; ++i)
+            expected = expected * a % m;
+
+        ASSERT_EQ(pow_mod(a, e, m), expected);
+        if ((m % 2) == 1)
+        {
+            ASSERT_EQ(pow_mod_sec(a, e, m), expected);
+        }
+    }
+}
+
+TEST(correctness, pow)
+{
+    EXPECT_EQ(pow(big_integer(0), 0), 1);
+    EXPECT_EQ(pow(big_integer(0), 5), 0);
+    EXPECT_EQ(pow(big_integer(-1), 7), -1);
+    EXPECT_EQ(pow(big_integer(-2), 100), big_integer(1) << 100);
+    EXPECT_EQ(pow(big_integer(-3), 5), -243);
+    EXPECT_EQ(to_string(pow(big_integer(10), 19)), "10000000000000000000");
+    EXPECT_EQ(to_string(pow(big_integer(-10), 21)), "-1000000000000000000000");
+    EXPECT_EQ(pow(big_integer(10), 40), big_integer("10000000000000000000000000000000000000000"));
+    EXPECT_EQ(pow(big_integer(-10), 1000), big_integer("1" + std::string(1000, '0')));
+    EXPECT_EQ(pow(big_integer(-10), 333), -big_integer("1" + std::string(333, '0')));
+    EXPECT_THROW(pow(big_integer(2), (uint64_t) 1 << 31), std::length_error);
+    EXPECT_THROW(pow(big_integer(12), (uint64_t) 1 << 62), std::length_error);
+    EXPECT_THROW(pow(big_integer(3), (uint64_t) 1 << 63), std::length_error);
+
+    for (size_t itn = 0; itn != 100; ++itn)
+    {
+        big_integer a = rand_big(rand() % 4);
+        if (rand() % 2)
+            a = -a;
+        if (rand() % 2)
+            a <<= rand() % 40;
+        unsigned e = rand() % 50;
+
+        big_integer expected = 1;
+        for (unsigned i = 0; i != e; ++i)
+            expected *= a;
+
+        ASSERT_EQ(pow(a, e), expected);
+    }
+}
+
+TEST(correctness, mul_square)
+{
+    big_integer a = rand_big(20);
+    big_integer b = a;
+    big_integer c = a + 0;
+
+    EXPECT_EQ(a * b, a * c);
+    EXPECT_EQ(-(a * a), (-a) * c);
+    EXPECT_EQ((-a) * (-a), a * c);
+}
+
+namespace
+{
+    big_integer euclid(big_integer a, big_integer b)
+    {
+        if (a < 0)
+            a = -a;
+        if (b < 0)
+            b = -b;
+        while (b != 0)
+        {
+            big_integer r = a % b;
+            a = b;
+            b = r;
+        }
+        return a;
+    }
+}
+
+TEST(correctness, gcd)
+{
+    EXPECT_EQ(gcd(0, 0), 0);
+    EXPECT_EQ(gcd(0, -5), 5);
+    EXPECT_EQ(gcd(-12, 18), 6);
+    EXPECT_EQ(lcm(-4, 6), 12);
+    EXPECT_EQ(lcm(0, 6), 0);
+
+    for (size_t itn = 0; itn != 300; ++itn)
+    {
+        big_integer g = rand_big(rand() % 10);
+        big_integer a = rand_big(rand() % 30) * g;
+        big_integer b = rand_big(rand() % 30) * g;
+        if (rand() % 2)
+            a = -a;
+
+        big_integer expected = euclid(a, b);
+        ASSERT_EQ(gcd(a, b), expected);
+        ASSERT_EQ(gcd(b, a), expected);
+        ASSERT_EQ(lcm(a, b) * expected, (a < 0 ? -a : a) * b);
+    }
+}
+
+TEST(correctness, gcdext)
+{
+    big_integer s, t;
+    EXPECT_EQ(gcdext(0, 0, s, t), 0);
+    EXPECT_EQ(gcdext(-7, 0, s, t), 7);
+    EXPECT_EQ(s, -1);
+    EXPECT_EQ(gcdext(240, 46, s, t), 2);
+    EXPECT_EQ(240 * s + 46 * t, 2);
+
+    for (size_t itn = 0; itn != 300; ++itn)
+    {
+        big_integer g = rand_big(rand() % 5);
+        big_integer a = rand_big(rand() % 25) * g;
+        big_integer b = rand_big(rand() % 25) * g;
+        if (rand() % 2)
+            a = -a;
+        if (rand() % 2)
+            b = -b;
+
+        big_integer d = gcdext(a, b, s, t);
+        ASSERT_EQ(d, euclid(a, b));
+        ASSERT_EQ(a * s + b * t, d);
+    }
+}
+
+TEST(correctness, mul_karatsuba)
+{
+    for (size_t itn = 0; itn != 30; ++itn)
+    {
+        big_integer a = rand_big(30 + rand() % 300);
+        big_integer b = rand_big(30 + rand() % 300);
+        if (rand() % 2)
+            a = -a;
+        big_integer c = a * b;
+
+        for (uint32_t p : {4294967291u, 4294967279u, 1000000007u})
+            ASSERT_EQ(c % p, (a % p) * (b % p) % p);
+        ASSERT_EQ(c / b, a);
+        ASSERT_EQ(a * a, (-a) * (a + 0) * -1);
+    }
+}
+
+TEST(correctness, gcd_huge)
+{
+    // gcd is the only common divisor of a and b that is their linear combination
+    for (size_t itn = 0; itn != 6; ++itn)
+    {
+        big_integer g = rand_big(rand() % 200);
+        big_integer a = rand_big(1100 + rand() % 500) * g;
+        big_integer b = rand_big(1100 + rand() % 500) * g;
+        if (rand() % 2)
+            b = -b;
+
+        big_integer s, t;
+        big_integer d = gcdext(a, b, s, t);
+        ASSERT_EQ(d, gcd(a, b));
+        ASSERT_EQ(a % d, 0);
+        ASSERT_EQ(b % d, 0);
+        ASSERT_EQ(a * s + b * t, d);
+        ASSERT_EQ(d % g, 0);
+    }
+}
+
+TEST(correctness, inverse_mod)
+{
+    big_integer inv;
+    EXPECT_TRUE(inverse_mod(3, 7, inv));
+    EXPECT_EQ(inv, 5);
+    EXPECT_TRUE(inverse_mod(-3, 7, inv));
+    EXPECT_EQ(inv, 2);
+    EXPECT_TRUE(inverse_mod(5, 1, inv));
+    EXPECT_EQ(inv, 0);
+    EXPECT_FALSE(inverse_mod(6, 9, inv));
+    EXPECT_FALSE(inverse_mod(0, 9, inv));
+
+    for (size_t itn = 0; itn != 200; ++itn)
+    {
+        big_integer m = rand_big(1 + rand() % 40);
+        big_integer a = rand_big(rand() % 45);
+        if (rand() % 2)
+            a = -a;
+
+        if (inverse_mod(a, m, inv))
+        {
+            ASSERT_GE(inv, 0);
+            ASSERT_LT(inv, m);
+            ASSERT_EQ((a * inv - 1) % m, 0);
+        }
+        else
+        {
+            ASSERT_NE(gcd(a, m), 1);
+        }
+    }
+}
+
+TEST(correctness, jacobi)
+{
+    EXPECT_EQ(jacobi(1001, 9907), -1);
+    EXPECT_EQ(jacobi(19, 45), 1);
+    EXPECT_EQ(jacobi(8, 21), -1);
+    EXPECT_EQ(jacobi(5, 21), 1);
+    EXPECT_EQ(jacobi(0, 1), 1);
+    EXPECT_EQ(jacobi(-1, 7), -1);
+    EXPECT_EQ(jacobi(15, 45), 0);
+
+    // Euler's criterion for Mersenne primes, multiplicativity for their product
+    big_integer p = (big_integer(1) << 127) - 1, q = (big_integer(1) << 521) - 1;
+    for (size_t itn = 0; itn != 50; ++itn)
+    {
+        big_integer a = rand_big(rand() % 40);
+        if (rand() % 2)
+            a = -a;
+
+        int jp = jacobi(a, p), jq = jacobi(a, q);
+        big_integer ep = pow_mod(a % p + p, (p - 1) / 2, p), eq = pow_mod(a % q + q, (q - 1) / 2, q);
+        ASSERT_EQ(jp, ep == p - 1 ? -1 : ep == 1 ? 1 : 0);
+        ASSERT_EQ(jq, eq == q - 1 ? -1 : eq == 1 ? 1 : 0);
+        ASSERT_EQ(jacobi(a, p * q), jp * jq);
+    }
+}
+
+TEST(correctness, isqrt)
+{
+    big_integer rem;
+    EXPECT_EQ(isqrt(0), 0);
+    EXPECT_EQ(isqrt(15), 3);
+    EXPECT_EQ(isqrt_rem(16, rem), 4);
+    EXPECT_EQ(rem, 0);
+    EXPECT_EQ(isqrt(big_integer("18446744073709551615")), 4294967295u);
+    EXPECT_EQ(isqrt(big_integer("100000000000000000000000000000000000000000")),
+              big_integer("316227766016837933199"));
+
+    for (size_t itn = 0; itn != 200; ++itn)
+    {
+        big_integer a = rand_big(rand() % 200);
+        big_integer s = isqrt_rem(a, rem);
+        ASSERT_EQ(s * s + rem, a);
+        ASSERT_GE(rem, 0);
+        ASSERT_LE(rem, 2 * s);
+    }
+}
+
+TEST(correctness, iroot)
+{
+    EXPECT_EQ(iroot(26, 3), 2);
+    EXPECT_EQ(iroot(27, 3), 3);
+    EXPECT_EQ(iroot(-27, 3), -3);
+    EXPECT_EQ(iroot(-26, 3), -2);
+    EXPECT_EQ(iroot(1023, 10), 1);
+    EXPECT_EQ(iroot(1024, 10), 2);
+
+    for (size_t itn = 0; itn != 100; ++itn)
+    {
+        big_integer a = rand_big(1 + rand() % 100);
+        uint32_t k = 3 + rand() % 30;
+        big_integer x = iroot(a, k);
+        ASSERT_LE(pow(x, k), a);
+        ASSERT_GT(pow(x + 1, k), a);
+    }
+}
+
+TEST(correctness, perfect_powers)
+{
+    EXPECT_TRUE(is_perfect_square(0));
+    EXPECT_TRUE(is_perfect_square(1));
+    EXPECT_FALSE(is_perfect_square(2));
+    EXPECT_FALSE(is_perfect_square(-4));
+    EXPECT_TRUE(is_perfect_power(-8));
+    EXPECT_FALSE(is_perfect_power(-4));
+    EXPECT_TRUE(is_perfect_power(1u << 30));
+    EXPECT_FALSE(is_perfect_power(6));
+
+    for (size_t itn = 0; itn != 30; ++itn)
+    {
+        big_integer x = rand_big(1 + rand() % 20) + 4;
+        uint32_t k = 2 + rand() % 10;
+        ASSERT_EQ(is_perfect_square(x * x + 1), false);
+        ASSERT_EQ(is_perfect_square(x * x), true);
+        ASSERT_EQ(is_perfect_power(pow(x, k)), true);
+        ASSERT_EQ(is_perfect_power(pow(x, k) - 1), false);
+        ASSERT_EQ(is_perfect_power(-pow(x, 2 * k + 1)), true);
+    }
+}
+
+TEST(correctness, is_probable_prime)
+{
+    EXPECT_FALSE(is_probable_prime(-7));
+    EXPECT_FALSE(is_probable_prime(1));
+    EXPECT_TRUE(is_probable_prime(2));
+    EXPECT_TRUE(is_probable_prime(997));
+    EXPECT_FALSE(is_probable_prime(561));
+    // Strong pseudoprimes to base 2 without small factors
+    for (uint32_t n : {1194649u, 1678541u, 2284453u, 2304167u, 3090091u})
+        EXPECT_FALSE(is_probable_prime(n));
+    EXPECT_TRUE(is_probable_prime((big_integer(1) << 127) - 1));
+    EXPECT_TRUE(is_probable_prime((big_integer(1) << 521) - 1, 5));
+    EXPECT_FALSE(is_probable_prime((big_integer(1) << 523) - 1));
+
+    for (uint32_t n = 1000001; n < 1030000; n += 2)
+    {
+        bool prime = true;
+        for (uint32_t d = 3; d * d <= n && prime; d += 2)
+            prime = n % d != 0;
+        ASSERT_EQ(is_probable_prime(n), prime);
+    }
+}
+
+TEST(correctness, next_prime)
+{
+    EXPECT_EQ(next_prime(-5), 2);
+    EXPECT_EQ(next_prime(2), 3);
+    EXPECT_EQ(next_prime(13), 17);
+    EXPECT_EQ(next_prime(big_integer(1) << 64), (big_integer(1) << 64) + 13);
+    EXPECT_EQ(next_prime(big_integer("100000000000000000000")), big_integer("100000000000000000039"));
+
+    big_integer p = next_prime(big_integer(1) << 200);
+    big_integer q = next_prime(p);
+    EXPECT_TRUE(is_probable_prime(p, 10));
+    EXPECT_GT(q, p);
+    EXPECT_FALSE(is_probable_prime(p * q));
+}
+
+TEST(correctness, factorial)
+{
+    big_integer f = 1, odd = 1;
+    EXPECT_EQ(factorial(0), 1);
+    EXPECT_EQ(double_factorial(0), 1);
+    for (uint32_t n = 1; n != 400; ++n)
+    {
+        f *= n;
+        ASSERT_EQ(factorial(n), f);
+        if (n % 2 == 1)
+            odd *= n;
+        ASSERT_EQ(double_factorial(n), n % 2 == 1 ? odd : f / odd);
+    }
+    EXPECT_EQ(factorial(3000) / factorial(2999), 3000);
+}
+
+TEST(correctness, binomial)
+{
+    EXPECT_EQ(binomial(5, 7), 0);
+    EXPECT_EQ(binomial(0, 0), 1);
+    EXPECT_EQ(binomial(1000000000000ull, 3), big_integer("166666666666166666666667000000000000"));
+    EXPECT_EQ(primorial(1), 1);
+    EXPECT_EQ(primorial(30), 6469693230ull);
+
+    for (uint64_t n = 100; n < 400; n += 37)
+        for (uint64_t k = 0; k <= n; k += 11)
+        {
+            ASSERT_EQ(binomial(n, k), factorial(n) / factorial(k) / factorial(n - k));
+            ASSERT_EQ(binomial(n + 1, k + 1), binomial(n, k) + binomial(n, k + 1));
+        }
+}
+
+TEST(correctness, remainder_tree)
+{
+    std::vector<big_integer> factors;
+    for (size_t i = 0; i != 101; ++i)
+        factors.push_back(i % 10 == 0 ? big_integer(i + 1) : rand_big(rand() % 60));
+
+    for (size_t threads = 1; threads <= 3; ++threads)
+    {
+        set_thread_count(threads);
+        subproduct_tree tree = product_tree(factors);
+        big_integer product = 1;
+        for (big_integer const& f : factors)
+            product *= f;
+        EXPECT_EQ(tree.product(), product);
+
+        big_integer x = rand_big(4000);
+        for (big_integer const& y : {x, -x, x % product, product, big_integer(0)})
+        {
+            std::vector<big_integer> r = remainder_tree(y, tree);
+            ASSERT_EQ(r.size(), factors.size());
+            for (size_t i = 0; i != factors.size(); ++i)
+            {
+                big_integer expected = y % factors[i];
+                ASSERT_EQ(r[i], expected < 0 ? expected + factors[i] : expected);
+            }
+        }
+    }
+    set_thread_count(1);
+
+    subproduct_tree single = product_tree({big_integer(7)});
+    EXPECT_EQ(remainder_tree(-1, single), std::vector<big_integer>({6}));
+}
+
+TEST(correctness, crt_words)
+{
+    crt_context ctx(std::vector<uint32_t>({3, 5, 7}));
+    EXPECT_EQ(ctx.modulus(), 105);
+    EXPECT_EQ(ctx.reconstruct(std::vector<uint32_t>({2, 3, 2})), 23);
+    EXPECT_EQ(ctx.reconstruct(std::vector<big_integer>({-1, -1, -1})), 104);
+
+    std::vector<uint32_t> moduli;
+    for (uint32_t m = 4294967291u; moduli.size() != 300; m -= 2)
+        if (is_probable_prime(m))
+            moduli.push_back(m);
+    crt_context primes(moduli);
+
+    big_integer x = rand_big(250);
+    std::vector<uint32_t> residues;
+    for (uint32_t m : moduli)
+        residues.push_back((x % m).get_digit(0, false));
+    EXPECT_EQ(primes.reconstruct(residues), x);
+}
+
+TEST(correctness, crt_big)
+{
+    std::vector<big_integer> moduli = {1};
+    for (size_t i = 0; i != 40; ++i)
+        moduli.push_back(next_prime(rand_big(rand() % 12)));
+    crt_context ctx(moduli);
+
+    big_integer product = 1;
+    for (big_integer const& m : moduli)
+        product *= m;
+    EXPECT_EQ(ctx.modulus(), product);
+
+    for (big_integer x : {rand_big(400) % product, product - 1, big_integer(0)})
+    {
+        std::vector<big_integer> residues;
+        for (big_integer const& m : moduli)
+            residues.push_back(x % m + m * (rand() % 3 - 1));
+        EXPECT_EQ(ctx.reconstruct(residues), x);
+    }
+}
+
+TEST(correctness, fibonacci)
+{
+    EXPECT_EQ(fibonacci(0), 0);
+    EXPECT_EQ(fibonacci(1), 1);
+    EXPECT_EQ(lucas(0), 2);
+    EXPECT_EQ(lucas(1), 1);
+    EXPECT_EQ(fibonacci(100), big_integer("354224848179261915075"));
+    EXPECT_EQ(lucas(100), big_integer("792070839848372253127"));
+
+    big_integer f = 0, g = 1, l = 2, k = 1;
+    for (uint64_t n = 0; n != 300; ++n)
+    {
+        ASSERT_EQ(fibonacci(n), f);
+        ASSERT_EQ(lucas(n), l);
+        std::swap(f, g);
+        g += f;
+        std::swap(l, k);
+        k += l;
+    }
+
+    big_integer fn = fibonacci(100000), ln = lucas(100000);
+    EXPECT_EQ(fibonacci(200000), fn * ln);
+    EXPECT_EQ(ln * ln - 5 * fn * fn, 4);
+}
+
+TEST(correctness, lucas_sequence)
+{
+    big_integer u, v;
+    lucas_sequence(1, -1, 1000, big_integer(1) << 70, u, v);
+    EXPECT_EQ(u, fibonacci(1000) % (big_integer(1) << 70));
+    EXPECT_EQ(v, lucas(1000) % (big_integer(1) << 70));
+    lucas_sequence(3, 2, 5, 1, u, v);
+    EXPECT_EQ(u, 0);
+
+    for (size_t itn = 0; itn != 30; ++itn)
+    {
+        big_integer p = rand_big(rand() % 3) - rand_big(1), q = rand_big(rand() % 3) - rand_big(1);
+        big_integer m = rand_big(rand() % 4) + 1;
+        uint32_t n = rand() % 200;
+
+        big_integer un = 0, vn = 2, un1 = 1, vn1 = p;
+        for (uint32_t i = 0; i != n; ++i)
+        {
+            big_integer t = p * un1 - q * un;
+            un = un1;
+            un1 = t;
+            t = p * vn1 - q * vn;
+            vn = vn1;
+            vn1 = t;
+        }
+        lucas_sequence(p, q, n, m, u, v);
+        un %= m;
+        vn %= m;
+        ASSERT_EQ(u, un < 0 ? un + m : un);
+        ASSERT_EQ(v, vn < 0 ? vn + m : vn);
+    }
+}
+
+namespace
+{
+    size_t nested_sum(thread_pool& pool, size_t begin, size_t end)
+    {
+        if (end - begin == 1)
+            return begin;
+        size_t mid = begin + (end - begin) / 2, left = 0;
+        task_group group(pool);
+        group.spawn([&] { left = nested_sum(pool, begin, mid); });
+        size_t right = nested_sum(pool, mid, end);
+        group.wait();
+        return left + right;
+    }
+}
+
+TEST(correctness, thread_pool)
+{
+    for (size_t workers = 0; workers != 4; ++workers)
+    {
+        thread_pool pool(workers);
+        EXPECT_EQ(pool.size(), workers);
+        EXPECT_EQ(nested_sum(pool, 0, 1000), 499500u);
+    }
+}
+
+TEST(correctness, task_group_exception)
+{
+    for (size_t workers = 0; workers != 4; ++workers)
+    {
+        thread_pool pool(workers);
+        std::atomic<size_t> finished(0);
+        task_group group(pool);
+        for (size_t i = 0; i != 16; ++i)
+            group.spawn([&finished, i] {
+                if (i % 5 == 3)
+                    throw std::runtime_error("task failed");
+                ++finished;
+            });
+        EXPECT_THROW(group.wait(), std::runtime_error);
+        EXPECT_EQ(finished, 13u);
+
+        group.spawn([&finished] { ++finished; });
+        EXPECT_NO_THROW(group.wait());
+        EXPECT_EQ(finished, 14u);
+        EXPECT_EQ(nested_sum(pool, 0, 1000), 499500u);
+    }
+}
+
+TEST(correctness, mul_parallel)
+{
+    big_integer a = rand_big(5000), b = rand_big(3000), c = rand_big(11000);
+    big_integer ab = a * b, aa = a * a, ac = a * c, ca = -c * a;
+
+    set_thread_count(4);
+    EXPECT_EQ(thread_count(), 4u);
+    EXPECT_EQ(a * b, ab);
+    EXPECT_EQ(a * a, aa);
+    EXPECT_EQ(a * c, ac);
+    EXPECT_EQ(-c * a, ca);
+    EXPECT_EQ(ab / b, a);
+    set_thread_count(1);
+}
+
+TEST(correctness, to_string_huge)
+{
+    std::string digits = "7";
+    for (size_t i = 0; i != 30000; ++i)
+        digits += (char) ('0' + rand() % 10);
+    big_integer x(digits);
+
+    for (size_t threads : {1, 3})
+    {
+        set_thread_count(threads);
+        EXPECT_EQ(to_string(x), digits);
+        EXPECT_EQ(to_string(-x), "-" + digits);
+        for (uint64_t e : {1151, 1152, 2304, 9216, 20000})
+        {
+            big_integer p = pow(big_integer(10), e);
+            EXPECT_EQ(to_string(p), "1" + std::string(e, '0'));
+            EXPECT_EQ(to_string(p - 1), std::string(e, '9'));
+            EXPECT_EQ(to_string(1 - p), "-" + std::string(e, '9'));
+        }
+    }
+    set_thread_count(1);
+}
+
+TEST(correctness, div_newton)
+{
+    big_integer a = rand_big(6000), b = rand_big(2700), c = rand_big(2700);
+    big_integer two = big_integer(1) << 85000;
+    for (big_integer const& d : {b, -b, two, two - 1, c})
+        for (big_integer const& n : {a, -a, d * c, d * c - 1, d * d + d})
+        {
+            big_integer q, r;
+            divmod(n, d, q, r);
+            ASSERT_EQ(q * d + r, n);
+            ASSERT_TRUE(r == 0 || (r < 0) == (n < 0));
+            ASSERT_TRUE((r < 0 ? -r : r) < (d < 0 ? -d : d));
+        }
+}
+
+TEST(correctness, from_string_huge)
+{
+    EXPECT_EQ(big_integer("0x0"), 0);
+    EXPECT_EQ(big_integer("-0xfF"), -255);
+    EXPECT_EQ(big_integer("0x123456789abcdef01"), big_integer("20988295479420645121"));
+
+    std::vector<uint32_t> words(3000);
+    std::string hex = "0x";
+    for (size_t i = words.size(); i-- > 0;)
+    {
+        words[i] = (uint32_t) rand() * 2 + (rand() & 1);
+        char buf[9];
+        snprintf(buf, sizeof buf, "%08X", words[i]);
+        hex += buf;
+    }
+
+    for (size_t threads : {1, 3})
+    {
+        set_thread_count(threads);
+        EXPECT_EQ(big_integer(hex), from_digits(words.data(), words.size()));
+        EXPECT_EQ(big_integer("-" + hex), -from_digits(words.data(), words.size()));
+        for (uint64_t e : {700, 1152, 5000, 30000})
+        {
+            big_integer p = pow(big_integer(10), e);
+            EXPECT_EQ(big_integer("1" + std::string(e, '0')), p);
+            EXPECT_EQ(big_integer(std::string(e, '9')), p - 1);
+            EXPECT_EQ(big_integer("-000" + std::string(e, '9')), 1 - p);
+        }
+    }
+    set_thread_count(1);
+}
+
+TEST(correctness, big_integer_batch)
+{
+    for (size_t width : {1, 4, 9})
+    {
+        big_integer mod = big_integer(1) << (int32_t) (32 * width);
+        std::vector<big_integer> xs, ys;
+        for (size_t i = 0; i != 1000; ++i)
+        {
+            xs.push_back(rand_big(width) % mod);
+            ys.push_back(i % 7 == 0 ? xs.back() : rand_big(rand() % width) % mod);
+        }
+        big_integer_batch a(xs, width), b(ys, width);
+        EXPECT_EQ(a.to_vector(), xs);
+
+        std::vector<big_integer> sum = (a + b).to_vector(), difference = (a - b).to_vector();
+        std::vector<big_integer> product = (a * b).to_vector();
+        std::vector<big_integer> left = (a << 45).to_vector(), right = (a >> 37).to_vector();
+        std::vector<int> order = compare(a, b), wide_order = compare(a * b, b);
+        for (size_t i = 0; i != xs.size(); ++i)
+        {
+            EXPECT_EQ(sum[i], (xs[i] + ys[i]) % mod);
+            EXPECT_EQ(difference[i], (xs[i] - ys[i] + mod) % mod);
+            EXPECT_EQ(product[i], xs[i] * ys[i]);
+            EXPECT_EQ(left[i], (xs[i] << 45) % mod);
+            EXPECT_EQ(right[i], xs[i] >> 37);
+            EXPECT_EQ(order[i], xs[i] < ys[i] ? -1 : (xs[i] > ys[i] ? 1 : 0));
+            EXPECT_EQ(wide_order[i], product[i] < ys[i] ? -1 : (product[i] > ys[i] ? 1 : 0));
+        }
+    }
+}
+
+TEST(correctness, sum_and_product)
+{
+    std::vector<big_integer> empty;
+    EXPECT_EQ(sum(empty.begin(), empty.end()), 0);
+    EXPECT_EQ(product(empty.begin(), empty.end()), 1);
+
+    std::vector<big_integer> values;
+    for (size_t i = 0; i != 5000; ++i)
+    {
+        big_integer x = i % 3 == 0 ? (big_integer(1) << 96) - 1 : rand_big(rand() % 4);
+        values.push_back(i % 2 == 0 ? x : -x);
+    }
+    big_integer expected = 0;
+    for (big_integer const& x : values)
+        expected += x;
+
+    std::vector<big_integer> factors;
+    for (size_t i = 0; i != 300; ++i)
+        factors.push_back(i % 5 == 0 ? rand_big(rand() % 20) + 1 : big_integer(-(int) i - 1));
+    big_integer expected_product = 1;
+    for (big_integer const& x : factors)
+        expected_product *= x;
+
+    for (size_t threads : {1, 3})
+    {
+        set_thread_count(threads);
+        EXPECT_EQ(sum(values.begin(), values.end()), expected);
+        EXPECT_EQ(sum(values.begin() + 1, values.begin() + 2), values[1]);
+        EXPECT_EQ(product(factors.begin(), factors.end()), expected_product);
+        EXPECT_EQ(product(factors.begin(), factors.begin() + 1), factors[0]);
+    }
+    set_thread_count(1);
+}
+
+TEST(correctness, dot_and_addmul)
+{
+    sum_accumulator acc;
+    addmul(acc, 0, -5);
+    EXPECT_EQ(acc.value(), 0);
+    addmul(acc, -3, 7);
+    addmul(acc, -4, -4);
+    EXPECT_EQ(acc.value(), -5);
+
+    std::vector<big_integer> a, b;
+    for (size_t i = 0; i != 5000; ++i)
+    {
+        a.push_back(i % 3 == 0 ? -rand_big(rand() % 3) : rand_big(rand() % 3));
+        b.push_back(i % 1000 == 0 ? rand_big(40) : rand_big(rand() % 3));
+    }
+    big_integer expected = 0;
+    for (size_t i = 0; i != a.size(); ++i)
+        expected += a[i] * b[i];
+
+    for (size_t threads : {1, 3})
+    {
+        set_thread_count(threads);
+        EXPECT_EQ(dot(a, b), expected);
+        EXPECT_EQ(dot(a.data() + 1, b.data() + 1, 1), a[1] * b[1]);
+        EXPECT_EQ(dot(a.data(), b.data(), 0), 0);
+    }
+    set_thread_count(1);
+}
+
+namespace
+{
+    big_integer_matrix rand_matrix(size_t rows, size_t cols, size_t size)
+    {
+        big_integer_matrix a(rows, cols);
+        for (size_t i = 0; i != rows; ++i)
+            for (size_t j = 0; j != cols; ++j)
+                a(i, j) = rand() % 2 ? rand_big(rand() % (size + 1)) : -rand_big(rand() % (size + 1));
+        return a;
+    }
+}
+
+TEST(correctness, matrix)
+{
+    big_integer_matrix a({{2, -1, 0}, {-1, 2, -1}, {0, -1, 2}});
+    EXPECT_EQ(determinant(a), 4);
+    EXPECT_EQ(determinant_multimodular(a), 4);
+    big_integer_matrix swapped({{0, 1, 2}, {3, 4, 5}, {6, 7, 9}});
+    EXPECT_EQ(determinant(swapped), -3);
+    EXPECT_EQ(determinant_multimodular(swapped), -3);
+    big_integer_matrix singular({{1, 2, 3}, {2, 4, 6}, {1, 0, 1}});
+    EXPECT_EQ(determinant(singular), 0);
+    EXPECT_EQ(determinant_multimodular(singular), 0);
+    EXPECT_EQ(bareiss(singular), 2u);
+    EXPECT_EQ(determinant(big_integer_matrix(0, 0)), 1);
+
+    for (size_t threads : {1, 3})
+    {
+        set_thread_count(threads);
+        big_integer_matrix x = rand_matrix(20, 17, 3), y = rand_matrix(17, 35, 2);
+        big_integer_matrix expected(20, 35);
+        for (size_t i = 0; i != 20; ++i)
+            for (size_t j = 0; j != 35; ++j)
+                for (size_t k = 0; k != 17; ++k)
+                    expected(i, j) += x(i, k) * y(k, j);
+        EXPECT_EQ(x * y, expected);
+
+        big_integer_matrix p = rand_matrix(12, 12, 2), q = rand_matrix(12, 12, 1);
+        big_integer det = determinant(p);
+        EXPECT_EQ(determinant_multimodular(p), det);
+        EXPECT_EQ(determinant(p * q), det * determinant(q));
+    }
+    set_thread_count(1);
+}
+
+TEST(correctness, divexact)
+{
+    EXPECT_EQ(divexact(0, 7), 0);
+    EXPECT_EQ(divexact(-91, 7), -13);
+    EXPECT_EQ(divexact_by_uint32(-96, 12), -8);
+    EXPECT_EQ(divexact(big_integer(1) << 100, -(big_integer(1) << 37)), -(big_integer(1) << 63));
+
+    for (std::pair<size_t, size_t> sizes : {std::make_pair(1, 1), std::make_pair(3, 5), std::make_pair(40, 2),
+                                            std::make_pair(100, 80), std::make_pair(300, 40),
+                                            std::make_pair(200, 400)})
+    {
+        for (size_t i = 0; i != 10; ++i)
+        {
+            big_integer q = rand_big(sizes.first), b = (rand_big(sizes.second) + 1) << (int32_t) (rand() % 70);
+            if (rand() % 2)
+                q = -q;
+            if (rand() % 2)
+                b = -b;
+            EXPECT_EQ(divexact(q * b, b), q);
+            uint32_t d = (uint32_t) rand() * 2 + 2;
+            EXPECT_EQ(divexact_by_uint32(q * d, d), q);
+        }
+    }
+
+    big_integer q = rand_big(2600), b = rand_big(2600) + 1;
+    EXPECT_EQ(divexact(q * b, b), q);
+}
+
+TEST(correctness, serialization)
+{
+    std::vector<big_integer> values = {0, 1, -1, big_integer(1) << 32, -(big_integer(1) << 200) + 7};
+    for (size_t i = 0; i != 20; ++i)
+        values.push_back(rand() % 2 ? rand_big(rand() % 30) : -rand_big(rand() % 30));
+
+    // Odd offset, so that no digit is aligned
+    std::vector<uint8_t> buffer(1);
+    for (big_integer const& x : values)
+        serialize(x, buffer);
+    EXPECT_EQ(serialized_size(0), 8u);
+    EXPECT_EQ(serialized_size(-(big_integer(1) << 32)), 16u);
+
+    size_t pos = 1;
+    for (big_integer const& x : values)
+    {
+        big_integer_view view(buffer.data() + pos, buffer.size() - pos);
+        EXPECT_EQ(view.bytes(), serialized_size(x));
+        EXPECT_EQ(view.to_big_integer(), x);
+        EXPECT_EQ(view.negative(), x < 0);
+        EXPECT_EQ(view.get_digit(0), x.get_digit(0, false));
+        EXPECT_EQ(compare(view, x), 0);
+        EXPECT_EQ(compare(view, x + 1), -1);
+        EXPECT_EQ(compare(view, x - 1), 1);
+        EXPECT_EQ(compare(view, -x), x == 0 ? 0 : (x < 0 ? -1 : 1));
+
+        big_integer y;
+        EXPECT_EQ(deserialize(buffer.data() + pos, view.bytes() - 1, y), 0u);
+        EXPECT_EQ(deserialize(buffer.data() + pos, buffer.size() - pos, y), view.bytes());
+        EXPECT_EQ(y, x);
+        pos += view.bytes();
+    }
+    EXPECT_EQ(pos, buffer.size());
+
+    // Negative zero with a leading zero digit, as another writer might produce it
+    uint8_t foreign[] = {3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    big_integer_view zero(foreign, sizeof foreign);
+    EXPECT_FALSE(zero.negative());
+    EXPECT_EQ(zero.digits_qty(), 0u);
+    EXPECT_EQ(zero.bytes(), sizeof foreign);
+    EXPECT_EQ(zero.to_big_integer(), 0);
+    EXPECT_EQ(compare(zero, 0), 0);
+
+    // Truncated in the header and in the digits, and a length that overflows the size
+    EXPECT_THROW(big_integer_view(foreign, 7), std::invalid_argument);
+    EXPECT_THROW(big_integer_view(foreign, 11), std::invalid_argument);
+    EXPECT_THROW(big_integer_view(nullptr, 0), std::invalid_argument);
+    uint8_t huge[] = {0xfe, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 1, 2, 3, 4};
+    EXPECT_THROW(big_integer_view(huge, sizeof huge), std::invalid_argument);
+}
+
+TEST(correctness, varint)
+{
+    std::vector<std::pair<big_integer, size_t>> sizes = {{0, 1}, {-1, 1}, {63, 1}, {-64, 1}, {64, 2}, {-65, 2},
+                                                         {(big_integer(1) << 55) - 1, 8}, {big_integer(1) << 55, 9},
+                                                         {-(big_integer(1) << 63), 10}, {big_integer(1) << 63, 10}};
+    for (auto const& value : sizes)
+    {
+        std::vector<uint8_t> buffer;
+        encode_varint(value.first, buffer);
+        EXPECT_EQ(buffer.size(), value.second);
+        big_integer decoded;
+        EXPECT_EQ(decode_varint(buffer.data(), buffer.size(), decoded), value.second);
+        EXPECT_EQ(decoded, value.first);
+        EXPECT_EQ(decode_varint(buffer.data(), buffer.size() - 1, decoded), 0u);
+    }
+
+    std::vector<big_integer> values;
+    for (size_t i = 0; i != 1000; ++i)
+    {
+        big_integer x = i % 50 == 0 ? rand_big(rand() % 40) : big_integer(rand() % (1 << (rand() % 30)));
+        if (i % 50 == 1)
+            x = (big_integer(1) << (int32_t) (32 * (rand() % 4))) - rand() % 2;
+        values.push_back(rand() % 2 ? x : -x);
+    }
+    std::vector<uint8_t> buffer;
+    encode_varints(values, buffer);
+
+    std::vector<big_integer> decoded;
+    EXPECT_EQ(decode_varints(buffer.data(), buffer.size(), decoded), buffer.size());
+    EXPECT_EQ(decoded, values);
+
+    // A stream cut in the middle of a value is read up to it
+    size_t cut = buffer.size() - 1;
+    decoded.clear();
+    size_t read = decode_varints(buffer.data(), cut, decoded);
+    EXPECT_EQ(decoded.size(), values.size() - 1);
+    std::vector<uint8_t> single;
+    encode_varint(values.back(), single);
+    EXPECT_EQ(read, buffer.size() - single.size());
+}
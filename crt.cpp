@@ -0,0 +1,84 @@
+#include "crt.h"
+#include "number_theory.h"
+
+#include <assert.h>
+
+crt_context::crt_context(std::vector<uint32_t> const &moduli)
+    : tree(product_tree(std::vector<big_integer>(moduli.begin(), moduli.end()))) {
+    init();
+}
+
+crt_context::crt_context(std::vector<big_integer> const &moduli) : tree(product_tree(moduli)) {
+    init();
+}
+
+// (M / P) mod P goes down the tree: for a child P_u with sibling P_w it is (M / P_v) * P_w mod P_u
+void crt_context::init() {
+    std::vector<big_integer> cofactors(1, 1 % tree.product());
+    for (size_t level = tree.levels.size() - 1; level-- > 0;) {
+        std::vector<big_integer> const &nodes = tree.levels[level];
+        std::vector<big_integer> below(nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            size_t sibling = i ^ 1;
+            below[i] = sibling < nodes.size() ? cofactors[i / 2] * nodes[sibling] % nodes[i] : cofactors[i / 2];
+        }
+        cofactors.swap(below);
+    }
+
+    inverses.resize(size());
+    for (size_t i = 0; i < size(); ++i) {
+        bool coprime = inverse_mod(cofactors[i], tree.levels[0][i], inverses[i]);
+        assert (coprime);
+        (void) coprime;
+    }
+}
+
+big_integer crt_context::combine(std::vector<big_integer> terms) const {
+    for (size_t level = 0; level + 1 < tree.levels.size(); ++level) {
+        std::vector<big_integer> const &nodes = tree.levels[level];
+        for (size_t i = 0; i < terms.size(); i += 2) {
+            terms[i / 2] = i + 1 < terms.size() ? terms[i] * nodes[i + 1] + terms[i + 1] * nodes[i] : terms[i];
+        }
+        terms.resize((terms.size() + 1) / 2);
+    }
+    // The sum is below size() * M, so the last division has a short quotient
+    return terms[0] % tree.product();
+}
+
+big_integer crt_context::reconstruct(std::vector<uint32_t> const &residues) const {
+    assert (residues.size() == size());
+
+    std::vector<big_integer> terms(size());
+    for (size_t i = 0; i < size(); ++i) {
+        big_integer const &m = tree.levels[0][i];
+        if (m.digits_qty() == 1) {
+            uint64_t word = m.get_digit(0, false);
+            terms[i] = residues[i] % word * inverses[i].get_digit(0, false) % word;
+        } else {
+            terms[i] = inverses[i] * residues[i] % m;
+        }
+    }
+    return combine(std::move(terms));
+}
+
+big_integer crt_context::reconstruct(std::vector<big_integer> const &residues) const {
+    assert (residues.size() == size());
+
+    std::vector<big_integer> terms(size());
+    for (size_t i = 0; i < size(); ++i) {
+        big_integer const &m = tree.levels[0][i];
+        terms[i] = residues[i] % m * inverses[i] % m;
+        if (terms[i] < 0) {
+            terms[i] += m;
+        }
+    }
+    return combine(std::move(terms));
+}
+
+big_integer const &crt_context::modulus() const {
+    return tree.product();
+}
+
+size_t crt_context::size() const {
+    return tree.size();
+}
@@ -0,0 +1,39 @@
+#ifndef BIGINT_CRT_H
+#define BIGINT_CRT_H
+
+#include "big_integer.h"
+#include "product_tree.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Chinese remainder theorem for fixed pairwise coprime moduli m_i > 0.
+ * With M the product of the moduli, x = sum r_i * c_i * M / m_i (mod M)
+ * where c_i = (M / m_i)^(-1) mod m_i. The constants are found once by
+ * descending the subproduct tree, reconstruction then sums the terms
+ * bottom up as left * P_right + right * P_left, which is quasi-linear
+ * instead of the quadratic Garner's scheme.
+ */
+struct crt_context {
+    explicit crt_context(std::vector<uint32_t> const& moduli);
+    explicit crt_context(std::vector<big_integer> const& moduli);
+
+    // The only x from [0, M) with x = r_i (mod m_i), residues may be negative or unreduced
+    big_integer reconstruct(std::vector<uint32_t> const& residues) const;
+    big_integer reconstruct(std::vector<big_integer> const& residues) const;
+
+    big_integer const& modulus() const;
+    size_t size() const;
+
+private:
+    subproduct_tree tree;
+    // c_i from above
+    std::vector<big_integer> inverses;
+
+    void init();
+    big_integer combine(std::vector<big_integer> terms) const;
+};
+
+#endif //BIGINT_CRT_H
@@ -0,0 +1,24 @@
+#ifndef BIGINT_DIVISOR_1_H
+#define BIGINT_DIVISOR_1_H
+
+#include <cstdint>
+
+/*
+ * Single digit divisor with precomputed reciprocal
+ * (Moller, Granlund "Improved division by invariant integers", 2011).
+ * Dividing by it costs two multiplications per digit instead of
+ * a hardware division, so build it once and reuse for the same d.
+ */
+struct divisor_1 {
+    explicit divisor_1(uint32_t d);
+
+    // d itself
+    uint32_t value;
+    // d shifted so that its highest bit is set
+    uint32_t norm;
+    // floor((2^64 - 1) / norm) - 2^32
+    uint32_t inverse;
+    uint32_t shift;
+};
+
+#endif //BIGINT_DIVISOR_1_H
@@ -0,0 +1,483 @@
+#include "kernels.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <vector>
+
+const uint32_t LOG2_BASE = 32;
+
+uint32_t add_1(uint32_t *r, uint32_t const *a, size_t n, uint32_t b) {
+    uint32_t carry = b;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t sum = a[i] + carry;
+        carry = sum < carry;
+        r[i] = sum;
+    }
+    return carry;
+}
+
+uint32_t sub_1(uint32_t *r, uint32_t const *a, size_t n, uint32_t b) {
+    uint32_t borrow = b;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t x = a[i];
+        r[i] = x - borrow;
+        borrow = x < borrow;
+    }
+    return borrow;
+}
+
+uint32_t add_n(uint32_t *r, uint32_t const *a, uint32_t const *b, size_t n) {
+    uint32_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t sum = (uint64_t) a[i] + b[i] + carry;
+        r[i] = (uint32_t) sum;
+        carry = (uint32_t) (sum >> LOG2_BASE);
+    }
+    return carry;
+}
+
+uint32_t sub_n(uint32_t *r, uint32_t const *a, uint32_t const *b, size_t n) {
+    uint32_t borrow = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t difference = (uint64_t) a[i] - b[i] - borrow;
+        r[i] = (uint32_t) difference;
+        borrow = (uint32_t) (difference >> (LOG2_BASE * 2 - 1));
+    }
+    return borrow;
+}
+
+uint32_t add(uint32_t *r, uint32_t const *a, size_t an, uint32_t const *b, size_t bn) {
+    uint32_t carry = add_n(r, a, b, bn);
+    return add_1(r + bn, a + bn, an - bn, carry);
+}
+
+uint32_t sub(uint32_t *r, uint32_t const *a, size_t an, uint32_t const *b, size_t bn) {
+    uint32_t borrow = sub_n(r, a, b, bn);
+    return sub_1(r + bn, a + bn, an - bn, borrow);
+}
+
+uint32_t mul_1(uint32_t *r, uint32_t const *a, size_t n, uint32_t b) {
+    uint32_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t product = (uint64_t) a[i] * b + carry;
+        r[i] = (uint32_t) product;
+        carry = (uint32_t) (product >> LOG2_BASE);
+    }
+    return carry;
+}
+
+// (a[i] * b + carry) never exceeds 96 bits, so it is split as lo + (hi << 32)
+uint64_t mul_2(uint32_t *r, uint32_t const *a, size_t n, uint64_t b) {
+    auto lo = (uint32_t) b, hi = (uint32_t) (b >> LOG2_BASE);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t x = a[i];
+        uint64_t low = x * lo + (uint32_t) carry;
+        r[i] = (uint32_t) low;
+        carry = (low >> LOG2_BASE) + x * hi + (carry >> LOG2_BASE);
+    }
+    return carry;
+}
+
+uint32_t addmul_1(uint32_t *r, uint32_t const *a, size_t n, uint32_t b) {
+    uint32_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t product = (uint64_t) a[i] * b + r[i] + carry;
+        r[i] = (uint32_t) product;
+        carry = (uint32_t) (product >> LOG2_BASE);
+    }
+    return carry;
+}
+
+uint32_t submul_1(uint32_t *r, uint32_t const *a, size_t n, uint32_t b) {
+    uint32_t borrow = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t product = (uint64_t) a[i] * b + borrow;
+        auto low = (uint32_t) product;
+        borrow = (uint32_t) (product >> LOG2_BASE) + (r[i] < low);
+        r[i] -= low;
+    }
+    return borrow;
+}
+
+void mul_basecase(uint32_t *r, uint32_t const *a, size_t an, uint32_t const *b, size_t bn) {
+    r[an] = mul_1(r, a, an, b[0]);
+    for (size_t i = 1; i < bn; ++i) {
+        r[an + i] = addmul_1(r + i, a, an, b[i]);
+    }
+}
+
+// Products a[i] * a[j] with i < j are computed once and doubled
+void sqr_basecase(uint32_t *r, uint32_t const *a, size_t n) {
+    std::fill(r, r + 2 * n, 0);
+    for (size_t i = 0; i + 1 < n; ++i) {
+        r[i + n] = addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    }
+
+    uint32_t top = 0;
+    for (size_t i = 0; i < 2 * n; ++i) {
+        uint32_t x = r[i];
+        r[i] = (x << 1) | top;
+        top = x >> (LOG2_BASE - 1);
+    }
+
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t square = (uint64_t) a[i] * a[i];
+        uint64_t sum = (uint64_t) r[2 * i] + (uint32_t) square + carry;
+        r[2 * i] = (uint32_t) sum;
+        sum = (uint64_t) r[2 * i + 1] + (square >> LOG2_BASE) + (sum >> LOG2_BASE);
+        r[2 * i + 1] = (uint32_t) sum;
+        carry = sum >> LOG2_BASE;
+    }
+}
+
+/*
+ * Karatsuba: a = a1 * B^l + a0, b = b1 * B^l + b0, then
+ * a * b = z2 * B^2l + (z0 + z2 - (a0 - a1) * (b0 - b1)) * B^l + z0,
+ * where z0 = a0 * b0, z2 = a1 * b1, so three half-sized products are enough.
+ * Scratch takes less than 8n digits over all levels of recursion.
+ */
+// d = |x0 - x1| for x = x1 * B^l + x0, returns true if x0 < x1
+static bool difference(uint32_t *d, uint32_t const *x, size_t n, size_t l) {
+    std::fill(d, d + l, 0);
+    std::copy(x + l, x + n, d);
+    if (cmp_n(x, d, l) >= 0) {
+        sub_n(d, x, d, l);
+        return false;
+    }
+    sub_n(d, d, x, l);
+    return true;
+}
+
+// Splits a and b into da = |a0 - a1| and db = |b0 - b1|, returns the sign of their product
+static bool karatsuba_split(uint32_t *da, uint32_t *db, uint32_t const *a, uint32_t const *b, size_t n, size_t l,
+                            bool square) {
+    bool negative = difference(da, a, n, l);
+    return !square && (negative != difference(db, b, n, l));
+}
+
+// r holds z0 and z2, t takes 2l + 1 digits
+static void karatsuba_combine(uint32_t *r, uint32_t const *zm, uint32_t *t, size_t n, size_t l, bool negative) {
+    size_t h = n - l;
+    t[2 * l] = add(t, r, 2 * l, r + 2 * l, 2 * h);
+    if (negative) {
+        t[2 * l] += add_n(t, t, zm, 2 * l);
+    } else {
+        t[2 * l] -= sub_n(t, t, zm, 2 * l);
+    }
+    add(r + l, r + l, 2 * n - l, t, 2 * l + 1);
+}
+
+static void karatsuba(uint32_t *r, uint32_t const *a, uint32_t const *b, size_t n, bool square, uint32_t *scratch) {
+    if (n < KARATSUBA_THRESHOLD) {
+        if (square) {
+            sqr_basecase(r, a, n);
+        } else {
+            mul_basecase(r, a, n, b, n);
+        }
+        return;
+    }
+
+    size_t l = (n + 1) / 2, h = n - l;
+    uint32_t *da = scratch, *db = da + l, *zm = db + l, *t = zm + 2 * l;
+    uint32_t *next = t + 2 * l + 1;
+
+    // (a0 - a1) * (b0 - b1) is negative when exactly one of the differences is
+    bool negative = karatsuba_split(da, db, a, b, n, l, square);
+
+    karatsuba(r, a, b, l, square, next);
+    karatsuba(r + 2 * l, a + l, b + l, h, square, next);
+    karatsuba(zm, da, (square ? da : db), l, square, next);
+
+    karatsuba_combine(r, zm, t, n, l, negative);
+}
+
+// The same recursion with two of the three products spawned as tasks, each task has its own scratch
+static void karatsuba_parallel(uint32_t *r, uint32_t const *a, uint32_t const *b, size_t n, bool square) {
+    if (n < PARALLEL_MUL_THRESHOLD) {
+        std::vector<uint32_t> scratch(8 * n + 64);
+        karatsuba(r, a, b, n, square, scratch.data());
+        return;
+    }
+
+    size_t l = (n + 1) / 2, h = n - l;
+    std::vector<uint32_t> scratch(6 * l + 1);
+    uint32_t *da = scratch.data(), *db = da + l, *zm = db + l, *t = zm + 2 * l;
+    bool negative = karatsuba_split(da, db, a, b, n, l, square);
+    {
+        task_group group(default_pool());
+        group.spawn([=] { karatsuba_parallel(r, a, b, l, square); });
+        group.spawn([=] { karatsuba_parallel(r + 2 * l, a + l, b + l, h, square); });
+        karatsuba_parallel(zm, da, (square ? da : db), l, square);
+        group.wait();
+    }
+    karatsuba_combine(r, zm, t, n, l, negative);
+}
+
+void mul_n(uint32_t *r, uint32_t const *a, uint32_t const *b, size_t n) {
+    if (n < KARATSUBA_THRESHOLD) {
+        mul_basecase(r, a, n, b, n);
+        return;
+    }
+    std::vector<uint32_t> scratch(8 * n + 64);
+    karatsuba(r, a, b, n, false, scratch.data());
+}
+
+// Longer operand is cut into pieces of bn digits, each piece is a balanced product
+void mul(uint32_t *r, uint32_t const *a, size_t an, uint32_t const *b, size_t bn) {
+    if (bn < KARATSUBA_THRESHOLD) {
+        mul_basecase(r, a, an, b, bn);
+        return;
+    }
+
+    std::vector<uint32_t> scratch(10 * bn + 64);
+    uint32_t *piece = scratch.data() + 8 * bn + 64;
+    std::fill(r, r + an + bn, 0);
+    for (size_t i = 0; i < an; i += bn) {
+        size_t len = std::min(bn, an - i);
+        if (len == bn) {
+            karatsuba(piece, a + i, b, bn, false, scratch.data());
+        } else {
+            mul(piece, b, bn, a + i, len);
+        }
+        add(r + i, r + i, an + bn - i, piece, len + bn);
+    }
+}
+
+void sqr(uint32_t *r, uint32_t const *a, size_t n) {
+    if (n < KARATSUBA_THRESHOLD) {
+        sqr_basecase(r, a, n);
+        return;
+    }
+    std::vector<uint32_t> scratch(8 * n + 64);
+    karatsuba(r, a, a, n, true, scratch.data());
+}
+
+// Pieces of the longer operand are multiplied in parallel into separate buffers and summed afterwards
+void mul_parallel(uint32_t *r, uint32_t const *a, size_t an, uint32_t const *b, size_t bn) {
+    if (bn < PARALLEL_MUL_THRESHOLD) {
+        mul(r, a, an, b, bn);
+        return;
+    }
+    if (an == bn) {
+        karatsuba_parallel(r, a, b, bn, false);
+        return;
+    }
+
+    size_t pieces = (an + bn - 1) / bn;
+    std::vector<uint32_t> products(2 * bn * pieces);
+    {
+        task_group group(default_pool());
+        for (size_t k = 0; k < pieces; ++k) {
+            group.spawn([=, &products] {
+                size_t i = k * bn, len = std::min(bn, an - i);
+                if (len == bn) {
+                    karatsuba_parallel(products.data() + 2 * bn * k, a + i, b, bn, false);
+                } else {
+                    mul(products.data() + 2 * bn * k, b, bn, a + i, len);
+                }
+            });
+        }
+        group.wait();
+    }
+
+    std::fill(r, r + an + bn, 0);
+    for (size_t k = 0; k < pieces; ++k) {
+        size_t i = k * bn, len = std::min(bn, an - i);
+        add(r + i, r + i, an + bn - i, products.data() + 2 * bn * k, len + bn);
+    }
+}
+
+void sqr_parallel(uint32_t *r, uint32_t const *a, size_t n) {
+    if (n < PARALLEL_MUL_THRESHOLD) {
+        sqr(r, a, n);
+        return;
+    }
+    karatsuba_parallel(r, a, a, n, true);
+}
+
+uint32_t lshift(uint32_t *r, uint32_t const *a, size_t n, unsigned cnt) {
+    assert (0 < cnt && cnt < LOG2_BASE);
+    uint32_t out = a[n - 1] >> (LOG2_BASE - cnt);
+    for (size_t i = n - 1; i > 0; --i) {
+        r[i] = (a[i] << cnt) | (a[i - 1] >> (LOG2_BASE - cnt));
+    }
+    r[0] = a[0] << cnt;
+    return out;
+}
+
+uint32_t rshift(uint32_t *r, uint32_t const *a, size_t n, unsigned cnt) {
+    assert (0 < cnt && cnt < LOG2_BASE);
+    uint32_t out = a[0] << (LOG2_BASE - cnt);
+    for (size_t i = 0; i + 1 < n; ++i) {
+        r[i] = (a[i] >> cnt) | (a[i + 1] << (LOG2_BASE - cnt));
+    }
+    r[n - 1] = a[n - 1] >> cnt;
+    return out;
+}
+
+divisor_1::divisor_1(uint32_t d) : value(d), norm(0), inverse(0), shift(0) {
+    assert (d != 0);
+
+    while ((d << shift) >> (LOG2_BASE - 1) == 0) {
+        ++shift;
+    }
+    norm = d << shift;
+    inverse = (uint32_t) (UINT64_MAX / norm);
+}
+
+// Divides (u1, u0) by normalized d with u1 < d, returns quotient
+static inline uint32_t div_2by1(uint32_t &rem, uint32_t u1, uint32_t u0, uint32_t d, uint32_t inverse) {
+    uint64_t q = (uint64_t) inverse * u1 + (((uint64_t) u1 << LOG2_BASE) | u0);
+    auto q1 = (uint32_t) (q >> LOG2_BASE) + 1, q0 = (uint32_t) q;
+    uint32_t r = u0 - q1 * d;
+    if (r > q0) {
+        --q1;
+        r += d;
+    }
+    if (r >= d) {
+        ++q1;
+        r -= d;
+    }
+
+    rem = r;
+    return q1;
+}
+
+// Digit i of a << d.shift, the bits shifted out of the top are not included
+static inline uint32_t shifted_digit(uint32_t const *a, size_t i, uint32_t shift) {
+    if (shift == 0) {
+        return a[i];
+    }
+    return (a[i] << shift) | (i > 0 ? a[i - 1] >> (LOG2_BASE - shift) : 0);
+}
+
+uint32_t divrem_1(uint32_t *q, uint32_t const *a, size_t n, divisor_1 const &d) {
+    uint32_t rem = (d.shift == 0 ? 0 : a[n - 1] >> (LOG2_BASE - d.shift));
+    for (size_t i = n - 1; i != (size_t) (-1); --i) {
+        q[i] = div_2by1(rem, rem, shifted_digit(a, i, d.shift), d.norm, d.inverse);
+    }
+    return rem >> d.shift;
+}
+
+uint32_t mod_1(uint32_t const *a, size_t n, divisor_1 const &d) {
+    uint32_t rem = (d.shift == 0 ? 0 : a[n - 1] >> (LOG2_BASE - d.shift));
+    for (size_t i = n - 1; i != (size_t) (-1); --i) {
+        div_2by1(rem, rem, shifted_digit(a, i, d.shift), d.norm, d.inverse);
+    }
+    return rem >> d.shift;
+}
+
+// Building the reciprocal costs one division, so short numbers use hardware
+uint32_t divrem_1(uint32_t *q, uint32_t const *a, size_t n, uint32_t d) {
+    if (n > 1) {
+        return divrem_1(q, a, n, divisor_1(d));
+    }
+    uint32_t rem = a[0] % d;
+    q[0] = a[0] / d;
+    return rem;
+}
+
+uint32_t mod_1(uint32_t const *a, size_t n, uint32_t d) {
+    if (n > 1) {
+        return mod_1(a, n, divisor_1(d));
+    }
+    return a[0] % d;
+}
+
+// Newton iteration doubles correct low bits, d * d = 1 mod 8 for odd d
+uint32_t inverse_mod_base(uint32_t d) {
+    uint32_t inv = d;
+    for (size_t i = 0; i < 4; ++i) {
+        inv *= 2 - d * inv;
+    }
+    return inv;
+}
+
+// q[i] * d cancels the current digit, its high half is borrowed from the next one
+void divexact_1(uint32_t *q, uint32_t const *a, size_t n, uint32_t d) {
+    uint32_t inv = inverse_mod_base(d), borrow = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t x = a[i];
+        uint32_t y = x - borrow;
+        q[i] = y * inv;
+        borrow = (uint32_t) (((uint64_t) q[i] * d) >> LOG2_BASE) + (x < borrow);
+    }
+}
+
+/*
+ * Every step zeroes the lowest digit of the remainder, only the digits
+ * below qn are kept, so a step costs min(dn, qn - i) instead of dn
+ * multiplications and a quotient shorter than d is cheaper than by Knuth.
+ */
+void divexact_low(uint32_t *q, uint32_t *a, size_t qn, uint32_t const *d, size_t dn) {
+    uint32_t inv = inverse_mod_base(d[0]);
+    for (size_t i = 0; i < qn; ++i) {
+        q[i] = a[i] * inv;
+        size_t len = std::min(dn, qn - i);
+        uint32_t borrow = submul_1(a + i, d, len, q[i]);
+        for (size_t j = i + len; borrow != 0 && j < qn; ++j) {
+            uint32_t x = a[j];
+            a[j] = x - borrow;
+            borrow = x < borrow;
+        }
+    }
+}
+
+/*
+ * Knuth's algorithm D: a quotient digit estimated by the two leading digits of
+ * the divisor is at most one too big, then it is fixed by adding d back.
+ */
+void divrem_norm(uint32_t *q, uint32_t *a, size_t an, uint32_t const *d, size_t dn) {
+    assert (an >= dn && dn >= 2 && (d[dn - 1] >> (LOG2_BASE - 1)) == 1);
+
+    const uint64_t base = (uint64_t) 1 << LOG2_BASE;
+    uint64_t d1 = d[dn - 1], d2 = d[dn - 2];
+    size_t qn = an - dn;
+    q[qn] = (cmp_n(a + qn, d, dn) >= 0);
+    if (q[qn] != 0) {
+        sub_n(a + qn, a + qn, d, dn);
+    }
+
+    for (size_t j = qn - 1; j != (size_t) (-1); --j) {
+        uint64_t top = ((uint64_t) a[j + dn] << LOG2_BASE) | a[j + dn - 1];
+        uint64_t qhat = std::min(top / d1, base - 1), rhat = top - qhat * d1;
+        while (rhat < base && qhat * d2 > ((rhat << LOG2_BASE) | a[j + dn - 2])) {
+            --qhat;
+            rhat += d1;
+        }
+
+        uint32_t borrow = submul_1(a + j, d, dn, (uint32_t) qhat);
+        if (borrow > a[j + dn]) {
+            --qhat;
+            add_n(a + j, a + j, d, dn);
+        }
+        a[j + dn] = 0;
+        q[j] = (uint32_t) qhat;
+    }
+}
+
+void select_n(uint32_t *r, uint32_t const *a, uint32_t const *b, size_t n, bool condition) {
+    uint32_t mask = 0 - (uint32_t) condition;
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = (a[i] & mask) | (b[i] & ~mask);
+    }
+}
+
+int cmp_n(uint32_t const *a, uint32_t const *b, size_t n) {
+    for (size_t i = n - 1; i != (size_t) (-1); --i) {
+        if (a[i] != b[i]) {
+            return (a[i] < b[i] ? -1 : 1);
+        }
+    }
+    return 0;
+}
+
+int cmp(uint32_t const *a, size_t an, uint32_t const *b, size_t bn) {
+    if (an != bn) {
+        return (an < bn ? -1 : 1);
+    }
+    return cmp_n(a, b, an);
+}
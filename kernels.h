@@ -0,0 +1,94 @@
+#ifndef BIGINT_KERNELS_H
+#define BIGINT_KERNELS_H
+
+/*
+ * Routines over raw little-endian arrays of 32-bit digits.
+ * Apart from Karatsuba's scratch and parallel tasks they never allocate,
+ * and the result pointer may be equal to the first operand, so everything
+ * can work in place.
+ */
+
+#include "divisor_1.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// r = a + b, a has n digits, returns carry
+uint32_t add_1(uint32_t *r, uint32_t const *a, size_t n, uint32_t b);
+// r = a - b, a has n digits, returns borrow
+uint32_t sub_1(uint32_t *r, uint32_t const *a, size_t n, uint32_t b);
+
+// r = a + b, both have n digits, returns carry
+uint32_t add_n(uint32_t *r, uint32_t const *a, uint32_t const *b, size_t n);
+// r = a - b, both have n digits, returns borrow
+uint32_t sub_n(uint32_t *r, uint32_t const *a, uint32_t const *b, size_t n);
+
+// r = a + b, a has an >= bn digits, b has bn digits, returns carry
+uint32_t add(uint32_t *r, uint32_t const *a, size_t an, uint32_t const *b, size_t bn);
+// r = a - b, a has an >= bn digits, b has bn digits, returns borrow
+uint32_t sub(uint32_t *r, uint32_t const *a, size_t an, uint32_t const *b, size_t bn);
+
+// r = a * b, returns the highest digit
+uint32_t mul_1(uint32_t *r, uint32_t const *a, size_t n, uint32_t b);
+// r = a * b for two-digit b, returns the two highest digits
+uint64_t mul_2(uint32_t *r, uint32_t const *a, size_t n, uint64_t b);
+
+// r += a * b, a has n digits, returns the digit carried out of r[n - 1]
+uint32_t addmul_1(uint32_t *r, uint32_t const *a, size_t n, uint32_t b);
+// r -= a * b, a has n digits, returns the digit borrowed from r[n]
+uint32_t submul_1(uint32_t *r, uint32_t const *a, size_t n, uint32_t b);
+// r = a * b, r has an + bn digits and must not overlap a or b
+void mul_basecase(uint32_t *r, uint32_t const *a, size_t an, uint32_t const *b, size_t bn);
+// r = a * a, r has 2n digits and must not overlap a
+void sqr_basecase(uint32_t *r, uint32_t const *a, size_t n);
+
+// Karatsuba's method below this number of digits is slower than schoolbook one
+const size_t KARATSUBA_THRESHOLD = 32;
+
+// r = a * b, both have n digits, r has 2n digits and must not overlap a or b
+void mul_n(uint32_t *r, uint32_t const *a, uint32_t const *b, size_t n);
+// r = a * b for an >= bn, picks the method by size, r must not overlap a or b
+void mul(uint32_t *r, uint32_t const *a, size_t an, uint32_t const *b, size_t bn);
+// r = a * a, picks the method by size, r must not overlap a
+void sqr(uint32_t *r, uint32_t const *a, size_t n);
+
+// From this number of digits products are worth splitting into tasks of default_pool()
+const size_t PARALLEL_MUL_THRESHOLD = 2048;
+
+// Same as mul and sqr, the subproducts of Karatsuba's recursion and the pieces
+// of the longer operand run as tasks of default_pool()
+void mul_parallel(uint32_t *r, uint32_t const *a, size_t an, uint32_t const *b, size_t bn);
+void sqr_parallel(uint32_t *r, uint32_t const *a, size_t n);
+
+// r = a << cnt for 0 < cnt < 32, returns the bits shifted out at the bottom of a digit
+uint32_t lshift(uint32_t *r, uint32_t const *a, size_t n, unsigned cnt);
+// r = a >> cnt for 0 < cnt < 32, returns the bits shifted out at the top of a digit
+uint32_t rshift(uint32_t *r, uint32_t const *a, size_t n, unsigned cnt);
+
+// q = a / d, returns a % d
+uint32_t divrem_1(uint32_t *q, uint32_t const *a, size_t n, uint32_t d);
+uint32_t divrem_1(uint32_t *q, uint32_t const *a, size_t n, divisor_1 const &d);
+// Returns a % d without touching a
+uint32_t mod_1(uint32_t const *a, size_t n, uint32_t d);
+uint32_t mod_1(uint32_t const *a, size_t n, divisor_1 const &d);
+// q = a / d for an >= dn >= 2 and d with the highest bit set, q has an - dn + 1 digits,
+// a % d is left in the low dn digits of a
+void divrem_norm(uint32_t *q, uint32_t *a, size_t an, uint32_t const *d, size_t dn);
+
+// d^(-1) mod 2^32 for odd d
+uint32_t inverse_mod_base(uint32_t d);
+// q = a / d for odd d dividing a exactly, digits come from the bottom by multiplying with d^(-1) (Hensel)
+void divexact_1(uint32_t *q, uint32_t const *a, size_t n, uint32_t d);
+// q = (a / d) mod 2^(32 * qn) for odd d dividing a exactly, only the low qn digits of a are read
+// and they are destroyed, q must not overlap a
+void divexact_low(uint32_t *q, uint32_t *a, size_t qn, uint32_t const *d, size_t dn);
+
+// r = (condition ? a : b) without branches
+void select_n(uint32_t *r, uint32_t const *a, uint32_t const *b, size_t n, bool condition);
+
+// Compares a and b of equal length: -1, 0 or 1
+int cmp_n(uint32_t const *a, uint32_t const *b, size_t n);
+// Compares a and b of any length without leading zeros
+int cmp(uint32_t const *a, size_t an, uint32_t const *b, size_t bn);
+
+#endif //BIGINT_KERNELS_H
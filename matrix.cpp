@@ -0,0 +1,213 @@
+#include "matrix.h"
+#include "crt.h"
+#include "number_theory.h"
+#include "powering.h"
+#include "reduction.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <assert.h>
+
+namespace {
+    uint32_t pow_word(uint64_t a, uint32_t e, uint32_t p) {
+        uint64_t res = 1;
+        for (; e != 0; e >>= 1) {
+            if (e & 1) {
+                res = res * a % p;
+            }
+            a = a * a % p;
+        }
+        return (uint32_t) res;
+    }
+
+    // Determinant of the n x n matrix a modulo prime p by Gaussian elimination
+    uint32_t determinant_mod(std::vector<uint32_t> a, size_t n, uint32_t p) {
+        uint64_t det = 1;
+        for (size_t k = 0; k < n; ++k) {
+            size_t pivot = k;
+            while (pivot < n && a[pivot * n + k] == 0) {
+                ++pivot;
+            }
+            if (pivot == n) {
+                return 0;
+            }
+            if (pivot != k) {
+                std::swap_ranges(a.begin() + k * n, a.begin() + (k + 1) * n, a.begin() + pivot * n);
+                det = (p - det) % p;
+            }
+            det = det * a[k * n + k] % p;
+            uint64_t inverse = pow_word(a[k * n + k], p - 2, p);
+            for (size_t i = k + 1; i < n; ++i) {
+                uint64_t f = a[i * n + k] * inverse % p;
+                if (f == 0) {
+                    continue;
+                }
+                for (size_t j = k + 1; j < n; ++j) {
+                    a[i * n + j] = (uint32_t) ((a[i * n + j] + (p - f) * a[k * n + j]) % p);
+                }
+            }
+        }
+        return (uint32_t) det;
+    }
+
+    // x mod p for any sign of x
+    uint32_t residue(big_integer const &x, divisor_1 const &p) {
+        uint32_t r = (x % p).get_digit(0, false);
+        return x < 0 && r != 0 ? p.value - r : r;
+    }
+}
+
+big_integer_matrix::big_integer_matrix(size_t rows, size_t cols) : n(rows), m(cols), data(rows * cols) {}
+
+big_integer_matrix::big_integer_matrix(std::vector<std::vector<big_integer>> const &rows)
+    : big_integer_matrix(rows.size(), rows.empty() ? 0 : rows[0].size()) {
+    for (size_t i = 0; i < n; ++i) {
+        assert (rows[i].size() == m);
+        std::copy(rows[i].begin(), rows[i].end(), data.begin() + i * m);
+    }
+}
+
+size_t big_integer_matrix::rows() const {
+    return n;
+}
+
+size_t big_integer_matrix::cols() const {
+    return m;
+}
+
+big_integer &big_integer_matrix::operator()(size_t i, size_t j) {
+    assert (i < n && j < m);
+    return data[i * m + j];
+}
+
+big_integer const &big_integer_matrix::operator()(size_t i, size_t j) const {
+    assert (i < n && j < m);
+    return data[i * m + j];
+}
+
+void big_integer_matrix::swap_rows(size_t i, size_t k) {
+    std::swap_ranges(data.begin() + i * m, data.begin() + (i + 1) * m, data.begin() + k * m);
+}
+
+bool operator==(big_integer_matrix const &a, big_integer_matrix const &b) {
+    return a.n == b.n && a.m == b.m && a.data == b.data;
+}
+
+bool operator!=(big_integer_matrix const &a, big_integer_matrix const &b) {
+    return !(a == b);
+}
+
+big_integer_matrix operator*(big_integer_matrix const &a, big_integer_matrix const &b) {
+    assert (a.cols() == b.rows());
+    big_integer_matrix res(a.rows(), b.cols());
+    size_t row_tiles = (a.rows() + MATRIX_BLOCK - 1) / MATRIX_BLOCK;
+    parallel_for(row_tiles, [&](size_t tile) {
+        size_t i0 = tile * MATRIX_BLOCK, i1 = std::min(i0 + MATRIX_BLOCK, a.rows());
+        std::vector<sum_accumulator> acc(MATRIX_BLOCK * MATRIX_BLOCK);
+        for (size_t j0 = 0; j0 < b.cols(); j0 += MATRIX_BLOCK) {
+            size_t j1 = std::min(j0 + MATRIX_BLOCK, b.cols());
+            for (size_t k0 = 0; k0 < a.cols(); k0 += MATRIX_BLOCK) {
+                size_t k1 = std::min(k0 + MATRIX_BLOCK, a.cols());
+                for (size_t i = i0; i < i1; ++i) {
+                    for (size_t k = k0; k < k1; ++k) {
+                        for (size_t j = j0; j < j1; ++j) {
+                            addmul(acc[(i - i0) * MATRIX_BLOCK + j - j0], a(i, k), b(k, j));
+                        }
+                    }
+                }
+            }
+            for (size_t i = i0; i < i1; ++i) {
+                for (size_t j = j0; j < j1; ++j) {
+                    sum_accumulator &entry = acc[(i - i0) * MATRIX_BLOCK + j - j0];
+                    res(i, j) = entry.value();
+                    entry.clear();
+                }
+            }
+        }
+    });
+    return res;
+}
+
+size_t bareiss(big_integer_matrix &a) {
+    big_integer previous = 1;
+    size_t rank = 0;
+    for (size_t c = 0; c < a.cols() && rank < a.rows(); ++c) {
+        size_t pivot = rank;
+        while (pivot < a.rows() && a(pivot, c) == 0) {
+            ++pivot;
+        }
+        if (pivot == a.rows()) {
+            continue;
+        }
+        if (pivot != rank) {
+            a.swap_rows(pivot, rank);
+            for (size_t j = c; j < a.cols(); ++j) {
+                a(rank, j) = -a(rank, j);
+            }
+        }
+
+        // a(i, j) = (a(i, j) * a(rank, c) - a(i, c) * a(rank, j)) / previous, the division is exact
+        size_t r = rank;
+        parallel_for(a.rows() - r - 1, [&](size_t row) {
+            size_t i = r + 1 + row;
+            sum_accumulator acc;
+            for (size_t j = c + 1; j < a.cols(); ++j) {
+                addmul(acc, a(i, j), a(r, c));
+                submul(acc, a(i, c), a(r, j));
+                a(i, j) = divexact(acc.value(), previous);
+                acc.clear();
+            }
+            a(i, c) = 0;
+        });
+        previous = a(r, c);
+        ++rank;
+    }
+    return rank;
+}
+
+// The last pivot is the determinant of the whole matrix
+big_integer determinant(big_integer_matrix a) {
+    assert (a.rows() == a.cols());
+    size_t n = a.rows();
+    if (n == 0) {
+        return 1;
+    }
+    return bareiss(a) == n ? a(n - 1, n - 1) : 0;
+}
+
+big_integer determinant_multimodular(big_integer_matrix const &a) {
+    assert (a.rows() == a.cols());
+    size_t n = a.rows();
+
+    // |det| < 2^bound, the moduli must cover 2^(bound + 1) to recover the sign
+    size_t bound = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum_accumulator norm;
+        for (size_t j = 0; j < n; ++j) {
+            addmul(norm, a(i, j), a(i, j));
+        }
+        bound += (bit_length(norm.value()) + 1) / 2;
+    }
+    std::vector<uint32_t> primes;
+    for (uint32_t p = 4294967291u; 31 * primes.size() < bound + 2; p -= 2) {
+        if (is_probable_prime(p)) {
+            primes.push_back(p);
+        }
+    }
+
+    std::vector<uint32_t> residues(primes.size());
+    parallel_for(primes.size(), [&](size_t t) {
+        divisor_1 p(primes[t]);
+        std::vector<uint32_t> reduced(n * n);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                reduced[i * n + j] = residue(a(i, j), p);
+            }
+        }
+        residues[t] = determinant_mod(std::move(reduced), n, primes[t]);
+    });
+
+    crt_context ctx(primes);
+    big_integer det = ctx.reconstruct(residues);
+    return 2 * det > ctx.modulus() ? det - ctx.modulus() : det;
+}
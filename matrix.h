@@ -0,0 +1,63 @@
+#ifndef BIGINT_MATRIX_H
+#define BIGINT_MATRIX_H
+
+#include "big_integer.h"
+
+#include <cstddef>
+#include <vector>
+
+// Square tiles of that many entries are multiplied at once, so that they stay in cache
+const size_t MATRIX_BLOCK = 16;
+
+// Dense matrix over the integers, entries are stored row by row
+struct big_integer_matrix {
+    big_integer_matrix(size_t rows, size_t cols);
+    // All rows must have equal length
+    explicit big_integer_matrix(std::vector<std::vector<big_integer>> const& rows);
+
+    size_t rows() const;
+    size_t cols() const;
+
+    big_integer& operator()(size_t i, size_t j);
+    big_integer const& operator()(size_t i, size_t j) const;
+
+    void swap_rows(size_t i, size_t k);
+
+    friend bool operator==(big_integer_matrix const& a, big_integer_matrix const& b);
+    friend bool operator!=(big_integer_matrix const& a, big_integer_matrix const& b);
+
+private:
+    size_t n;
+    size_t m;
+    std::vector<big_integer> data;
+};
+
+bool operator==(big_integer_matrix const& a, big_integer_matrix const& b);
+bool operator!=(big_integer_matrix const& a, big_integer_matrix const& b);
+
+// Tiled product, every entry is one sum_accumulator fed by addmul, row tiles run in parallel
+big_integer_matrix operator*(big_integer_matrix const& a, big_integer_matrix const& b);
+
+/*
+ * Fraction-free Gaussian elimination (Bareiss), in place: every entry stays
+ * an integer because the 2x2 minors of step k are divisible exactly by the
+ * pivot of step k - 1, and it is a minor of the original matrix, so entries
+ * grow only linearly. Swapped rows have their sign changed, which keeps the
+ * determinant of every leading square. Leaves the row echelon form, returns
+ * the rank. Rows below the pivot are eliminated in parallel.
+ */
+size_t bareiss(big_integer_matrix& a);
+
+// Determinant by Bareiss elimination, a must be square
+big_integer determinant(big_integer_matrix a);
+
+/*
+ * Determinant from its residues modulo word primes reconstructed by crt_context.
+ * Enough primes are taken for the Hadamard bound |det| <= prod ||row_i||,
+ * the matrix is reduced and eliminated modulo every prime in parallel.
+ * Every prime costs a word-sized elimination, while the entries of Bareiss
+ * grow to the size of the determinant, so this is the faster one.
+ */
+big_integer determinant_multimodular(big_integer_matrix const& a);
+
+#endif //BIGINT_MATRIX_H
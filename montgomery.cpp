@@ -0,0 +1,148 @@
+#include "montgomery.h"
+#include "kernels.h"
+#include "powering.h"
+
+#include <algorithm>
+#include <assert.h>
+
+const uint32_t LOG2_BASE = 32;
+
+montgomery_context::montgomery_context(big_integer const &modulus) : m(modulus), mod(modulus.digits_qty()) {
+    assert (modulus > 0 && (modulus.get_digit(0, false) & 1) == 1);
+
+    size_t n = mod.size();
+    to_digits(m, mod.data(), n);
+
+    m_inv = 0 - inverse_mod_base(mod[0]);
+
+    r_mod.resize(n);
+    r2_mod.resize(n);
+    to_digits((big_integer(1) << (int32_t) (LOG2_BASE * n)) % m, r_mod.data(), n);
+    to_digits((big_integer(1) << (int32_t) (2 * LOG2_BASE * n)) % m, r2_mod.data(), n);
+}
+
+big_integer const &montgomery_context::modulus() const {
+    return m;
+}
+
+size_t montgomery_context::size() const {
+    return mod.size();
+}
+
+size_t montgomery_context::scratch_size() const {
+    return 2 * mod.size() + 2;
+}
+
+uint32_t const *montgomery_context::one() const {
+    return r_mod.data();
+}
+
+// The final subtraction of m is done always and chosen without branches,
+// so timing does not depend on the operands
+// Coarsely integrated operand scanning: reduction is interleaved with
+// multiplication digit by digit, so t never grows above n + 2 digits
+void montgomery_context::mul(uint32_t *res, uint32_t const *a, uint32_t const *b, uint32_t *scratch) const {
+    size_t n = mod.size();
+    uint32_t const *p = mod.data();
+    uint32_t *t = scratch;
+    std::fill(t, t + n + 2, 0);
+
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t sum = (uint64_t) t[n] + addmul_1(t, a, n, b[i]);
+        t[n] = (uint32_t) sum;
+        t[n + 1] = (uint32_t) (sum >> LOG2_BASE);
+
+        // t + q * m is divisible by 2^32, the division is a shift by one digit
+        uint32_t q = t[0] * m_inv;
+        uint64_t cur = (uint64_t) q * p[0] + t[0];
+        for (size_t j = 1; j < n; ++j) {
+            cur = (uint64_t) q * p[j] + t[j] + (cur >> LOG2_BASE);
+            t[j - 1] = (uint32_t) cur;
+        }
+        cur = (uint64_t) t[n] + (cur >> LOG2_BASE);
+        t[n - 1] = (uint32_t) cur;
+        t[n] = t[n + 1] + (uint32_t) (cur >> LOG2_BASE);
+    }
+
+    uint32_t borrow = sub_n(t + n + 2, t, p, n);
+    select_n(res, t + n + 2, t, n, t[n] != 0 || borrow == 0);
+}
+
+// Separated operand scanning: the square is computed first, then reduced
+void montgomery_context::sqr(uint32_t *res, uint32_t const *a, uint32_t *scratch) const {
+    sqr_basecase(scratch, a, mod.size());
+    reduce(res, scratch);
+}
+
+void montgomery_context::reduce(uint32_t *res, uint32_t *t) const {
+    size_t n = mod.size();
+    uint32_t const *p = mod.data();
+
+    // t[i] becomes zero after step i, so it keeps the carry out of that step
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t q = t[i] * m_inv;
+        t[i] = addmul_1(t + i, p, n, q);
+    }
+
+    uint32_t carry = add_n(t, t + n, t, n);
+    uint32_t borrow = sub_n(t + n, t, p, n);
+    select_n(res, t + n, t, n, carry != 0 || borrow == 0);
+}
+
+big_integer montgomery_context::to_montgomery(big_integer const &a) const {
+    big_integer r = a % m;
+    if (r < 0) {
+        r += m;
+    }
+
+    size_t n = mod.size();
+    std::vector<uint32_t> x(n), scratch(scratch_size());
+    to_digits(r, x.data(), n);
+    mul(x.data(), x.data(), r2_mod.data(), scratch.data());
+    return from_digits(x.data(), n);
+}
+
+big_integer montgomery_context::from_montgomery(big_integer const &a) const {
+    size_t n = mod.size();
+    std::vector<uint32_t> t(2 * n);
+    to_digits(a, t.data(), 2 * n);
+    reduce(t.data(), t.data());
+    return from_digits(t.data(), n);
+}
+
+big_integer montgomery_context::mul(big_integer const &a, big_integer const &b) const {
+    size_t n = mod.size();
+    std::vector<uint32_t> x(n), y(n), scratch(scratch_size());
+    to_digits(a, x.data(), n);
+    to_digits(b, y.data(), n);
+    mul(x.data(), x.data(), y.data(), scratch.data());
+    return from_digits(x.data(), n);
+}
+
+big_integer montgomery_context::sqr(big_integer const &a) const {
+    size_t n = mod.size();
+    std::vector<uint32_t> x(n), scratch(scratch_size());
+    to_digits(a, x.data(), n);
+    sqr(x.data(), x.data(), scratch.data());
+    return from_digits(x.data(), n);
+}
+
+big_integer montgomery_context::pow(big_integer const &a, big_integer const &e) const {
+    assert (e >= 0);
+
+    size_t n = mod.size();
+    std::vector<uint32_t> x(n), res(n), scratch(scratch_size());
+    to_digits(a, x.data(), n);
+    sliding_window_pow(*this, res.data(), x.data(), r_mod.data(), e, scratch.data());
+    return from_digits(res.data(), n);
+}
+
+big_integer montgomery_context::pow_sec(big_integer const &a, big_integer const &e) const {
+    assert (e >= 0);
+
+    size_t n = mod.size();
+    std::vector<uint32_t> x(n), res(n), scratch(scratch_size());
+    to_digits(a, x.data(), n);
+    fixed_window_pow(*this, res.data(), x.data(), r_mod.data(), e, scratch.data());
+    return from_digits(res.data(), n);
+}
@@ -0,0 +1,54 @@
+#ifndef BIGINT_MONTGOMERY_H
+#define BIGINT_MONTGOMERY_H
+
+#include "big_integer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Arithmetic modulo fixed odd m without divisions.
+ * Residue a is kept in Montgomery form a * R mod m, where R = 2^(32 * n)
+ * and n is the number of digits in m, so a product needs only
+ * a reduction by R, which is a shift.
+ *
+ * mul, sqr and pow take and return Montgomery forms.
+ * Raw versions work over n-digit arrays and the caller's scratch
+ * of scratch_size() digits, so loops over them never allocate.
+ */
+struct montgomery_context {
+    explicit montgomery_context(big_integer const& modulus);
+
+    big_integer to_montgomery(big_integer const& a) const;
+    big_integer from_montgomery(big_integer const& a) const;
+
+    big_integer mul(big_integer const& a, big_integer const& b) const;
+    big_integer sqr(big_integer const& a) const;
+    big_integer pow(big_integer const& a, big_integer const& e) const;
+    // Timing and memory access depend only on the number of digits in e
+    big_integer pow_sec(big_integer const& a, big_integer const& e) const;
+
+    big_integer const& modulus() const;
+    size_t size() const;
+    size_t scratch_size() const;
+
+    // R mod m, which is 1 in Montgomery form
+    uint32_t const *one() const;
+
+    // Output may coincide with any input
+    void mul(uint32_t *res, uint32_t const *a, uint32_t const *b, uint32_t *scratch) const;
+    void sqr(uint32_t *res, uint32_t const *a, uint32_t *scratch) const;
+    // res = t / R mod m, t has 2n digits and is destroyed
+    void reduce(uint32_t *res, uint32_t *t) const;
+
+private:
+    big_integer m;
+    std::vector<uint32_t> mod;
+    // -m^(-1) mod 2^32
+    uint32_t m_inv;
+    std::vector<uint32_t> r_mod;
+    std::vector<uint32_t> r2_mod;
+};
+
+#endif //BIGINT_MONTGOMERY_H
@@ -0,0 +1,1345 @@
+#include "number_theory.h"
+#include "montgomery.h"
+#include "barrett.h"
+#include "kernels.h"
+#include "powering.h"
+#include "reduction.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+const uint32_t LOG2_BASE = 32;
+// Half-GCD recursion stops at this many digits, Lehmer's algorithm is faster below
+const size_t HGCD_THRESHOLD = 400;
+// gcd and gcdext switch to half-GCD at these lengths, cofactors make Lehmer's algorithm slower
+const size_t GCD_HGCD_THRESHOLD = 3000;
+const size_t GCDEXT_HGCD_THRESHOLD = 1000;
+
+// Odd moduli go to Montgomery form, even ones to Barrett reduction
+big_integer pow_mod(big_integer const &base, big_integer const &exp, big_integer const &mod) {
+    assert (mod > 0 && exp >= 0);
+
+    if ((mod.get_digit(0, false) & 1) == 1) {
+        montgomery_context ctx(mod);
+        return ctx.from_montgomery(ctx.pow(ctx.to_montgomery(base), exp));
+    }
+
+    barrett_context ctx(mod);
+    return ctx.pow(ctx.reduce(base), exp);
+}
+
+big_integer pow_mod_sec(big_integer const &base, big_integer const &exp, big_integer const &mod) {
+    assert (mod > 0 && exp >= 0 && (mod.get_digit(0, false) & 1) == 1);
+
+    montgomery_context ctx(mod);
+    return ctx.from_montgomery(ctx.pow_sec(ctx.to_montgomery(base), exp));
+}
+
+namespace {
+    // Stein's algorithm for numbers of at most two digits
+    uint64_t binary_gcd(uint64_t a, uint64_t b) {
+        if (a == 0 || b == 0) {
+            return a | b;
+        }
+
+        int shift = __builtin_ctzll(a | b);
+        a >>= __builtin_ctzll(a);
+        while (b != 0) {
+            b >>= __builtin_ctzll(b);
+            if (a > b) {
+                std::swap(a, b);
+            }
+            b -= a;
+        }
+        return a << shift;
+    }
+
+    uint64_t to_word(big_integer const &a) {
+        return a.get_digit(0, false) | ((uint64_t) a.get_digit(1, false) << LOG2_BASE);
+    }
+
+    /*
+     * Remainders of Euclid's algorithm over digit arrays, x >= y >= 0.
+     * Arrays have capacity of x's initial length, lengths exclude leading zeros.
+     */
+    struct euclid_state {
+        std::vector<uint32_t> x, y, next_x, next_y;
+        size_t xn, yn;
+
+        euclid_state(big_integer const &a, big_integer const &b)
+                : x(a.digits_qty()), y(a.digits_qty()), next_x(a.digits_qty()), next_y(a.digits_qty()),
+                  xn(a.digits_qty()), yn(b.digits_qty()) {
+            to_digits(a, x.data(), xn);
+            to_digits(b, y.data(), xn);
+            trim();
+        }
+
+        void trim() {
+            while (xn > 0 && x[xn - 1] == 0) {
+                --xn;
+            }
+            while (yn > 0 && y[yn - 1] == 0) {
+                --yn;
+            }
+        }
+
+        big_integer first() const {
+            return from_digits(x.data(), xn);
+        }
+
+        big_integer second() const {
+            return from_digits(y.data(), yn);
+        }
+    };
+
+    // Cofactors of several Euclid steps: (x, y) <- (a * x + b * y, c * x + d * y)
+    struct lehmer_matrix {
+        int64_t a, b, c, d;
+    };
+
+    /*
+     * Knuth's algorithm L over the leading 63 bits of x and y taken at the same
+     * shift. A quotient is accepted only when both ends of its uncertainty
+     * interval agree, so the steps are exactly those of the full numbers.
+     * Cofactors are kept below 2^31 so they can be applied with one-digit kernels.
+     * When bounded, steps stop before the remainder may become less than 2^bound:
+     * the error of the approximation times 2^k is below 2^(k + 32).
+     */
+    lehmer_matrix lehmer_step(euclid_state const &s, bool bounded = false, size_t bound = 0) {
+        size_t n = s.xn;
+        int shift = __builtin_clz(s.x[n - 1]);
+        auto leading = [&](std::vector<uint32_t> const &v) {
+            uint64_t hi = ((uint64_t) v[n - 1] << LOG2_BASE) | v[n - 2];
+            uint32_t lo = (n >= 3 ? v[n - 3] : 0);
+            if (shift > 0) {
+                hi = (hi << shift) | (lo >> (LOG2_BASE - shift));
+            }
+            return (int64_t) (hi >> 1);
+        };
+        int64_t x = leading(s.x), y = leading(s.y);
+
+        const int64_t limit = (int64_t) 1 << 31;
+        lehmer_matrix m = {1, 0, 0, 1};
+        int64_t floor = 0;
+        if (bounded) {
+            int64_t k = (int64_t) LOG2_BASE * ((int64_t) n - 2) - shift + 1;
+            int64_t e = (int64_t) bound - k;
+            if (e >= 62) {
+                return m;
+            }
+            floor = (e > 0 ? (int64_t) 1 << e : 1) + (k > 0 ? (int64_t) 1 << 32 : 0);
+        }
+        while (y + m.c > 0 && y + m.d > 0 && x + m.a >= 0 && x + m.b >= 0) {
+            int64_t q = (x + m.a) / (y + m.c);
+            if (q != (x + m.b) / (y + m.d) || q >= limit) {
+                break;
+            }
+            int64_t c = m.a - q * m.c, d = m.b - q * m.d;
+            int64_t r = x - q * y;
+            if (c <= -limit || c >= limit || d <= -limit || d >= limit || r < floor) {
+                break;
+            }
+
+            m.a = m.c;
+            m.b = m.d;
+            m.c = c;
+            m.d = d;
+            x = y;
+            y = r;
+        }
+        return m;
+    }
+
+    // r = u * x + v * y for u, v not both negative when the result is known to fit n digits
+    void combine(uint32_t *r, uint32_t const *x, uint32_t const *y, size_t n, int64_t u, int64_t v) {
+        if (u < 0) {
+            std::swap(x, y);
+            std::swap(u, v);
+        }
+        uint32_t high = mul_1(r, x, n, (uint32_t) u);
+        if (v >= 0) {
+            high += addmul_1(r, y, n, (uint32_t) v);
+        } else {
+            high -= submul_1(r, y, n, (uint32_t) -v);
+        }
+        assert (high == 0);
+        (void) high;
+    }
+
+    // One division step for huge quotients, returns the quotient
+    big_integer division_step(euclid_state &s) {
+        big_integer x = s.first(), y = s.second();
+        big_integer q = x / y;
+        big_integer r = x - q * y;
+        std::copy(s.y.begin(), s.y.begin() + s.yn, s.x.begin());
+        std::fill(s.x.begin() + s.yn, s.x.end(), 0);
+        to_digits(r, s.y.data(), s.y.size());
+        s.xn = s.yn;
+        s.yn = r.digits_qty();
+        s.trim();
+        return q;
+    }
+
+    /*
+     * Coefficients u, v of the initial x (or y) in current x and y.
+     * Their signs alternate, so under a Lehmer matrix only magnitudes add up.
+     */
+    struct cofactors {
+        std::vector<uint32_t> u, v, next_u, next_v;
+        size_t un, vn;
+        bool u_negative, v_negative;
+
+        cofactors(size_t capacity, bool of_x)
+                : u(capacity), v(capacity), next_u(capacity), next_v(capacity),
+                  un(of_x), vn(!of_x), u_negative(false), v_negative(false) {
+            u[0] = of_x;
+            v[0] = !of_x;
+        }
+
+        void apply(lehmer_matrix const &m) {
+            size_t n = std::max(un, vn);
+            std::fill(u.begin() + un, u.begin() + n, 0);
+            std::fill(v.begin() + vn, v.begin() + n, 0);
+
+            next_u[n] = mul_1(next_u.data(), u.data(), n, (uint32_t) std::abs(m.a));
+            next_u[n] += addmul_1(next_u.data(), v.data(), n, (uint32_t) std::abs(m.b));
+            next_v[n] = mul_1(next_v.data(), u.data(), n, (uint32_t) std::abs(m.c));
+            next_v[n] += addmul_1(next_v.data(), v.data(), n, (uint32_t) std::abs(m.d));
+
+            bool next_u_negative = (m.a != 0 && un > 0 ? (m.a < 0) != u_negative : (m.b < 0) != v_negative);
+            v_negative = (m.c != 0 && un > 0 ? (m.c < 0) != u_negative : (m.d < 0) != v_negative);
+            u_negative = next_u_negative;
+            std::swap(u, next_u);
+            std::swap(v, next_v);
+            un = vn = n + 1;
+            trim();
+        }
+
+        void apply(big_integer const &q) {
+            big_integer w = first() - q * second();
+            std::copy(v.begin(), v.begin() + vn, u.begin());
+            un = vn;
+            u_negative = v_negative;
+            vn = w.digits_qty();
+            to_digits(w, v.data(), vn);
+            v_negative = w < 0;
+            trim();
+        }
+
+        void trim() {
+            while (un > 0 && u[un - 1] == 0) {
+                --un;
+            }
+            while (vn > 0 && v[vn - 1] == 0) {
+                --vn;
+            }
+        }
+
+        big_integer first() const {
+            return from_digits(u.data(), un, u_negative);
+        }
+
+        big_integer second() const {
+            return from_digits(v.data(), vn, v_negative);
+        }
+    };
+
+    // Applies m to the remainders and to the cofactors which are given
+    void lehmer_apply(euclid_state &s, lehmer_matrix const &m, cofactors *cx, cofactors *cy) {
+        size_t n = s.xn;
+        combine(s.next_x.data(), s.x.data(), s.y.data(), n, m.a, m.b);
+        combine(s.next_y.data(), s.x.data(), s.y.data(), n, m.c, m.d);
+        std::swap(s.x, s.next_x);
+        std::swap(s.y, s.next_y);
+        s.yn = n;
+        s.trim();
+        if (cx != nullptr) {
+            cx->apply(m);
+        }
+        if (cy != nullptr) {
+            cy->apply(m);
+        }
+    }
+
+    // Applies lehmer_step until y fits into two digits, cofactors are tracked if given
+    void lehmer_reduce(euclid_state &s, cofactors *cx, cofactors *cy) {
+        while (s.yn > 2) {
+            lehmer_matrix m = lehmer_step(s);
+            if (m.b == 0) {
+                big_integer q = division_step(s);
+                if (cx != nullptr) {
+                    cx->apply(q);
+                }
+                if (cy != nullptr) {
+                    cy->apply(q);
+                }
+                continue;
+            }
+
+            lehmer_apply(s, m, cx, cy);
+        }
+    }
+
+    // Matrix of steps over big integers: (x, y) <- (a * x + b * y, c * x + d * y)
+    struct hgcd_matrix {
+        big_integer a, b, c, d;
+    };
+
+    const hgcd_matrix identity = {1, 0, 0, 1};
+
+    // Matrix of m steps followed by n steps
+    hgcd_matrix compose(hgcd_matrix const &n, hgcd_matrix const &m) {
+        return {n.a * m.a + n.b * m.c, n.a * m.b + n.b * m.d,
+                n.c * m.a + n.d * m.c, n.c * m.b + n.d * m.d};
+    }
+
+    void transform(hgcd_matrix const &m, big_integer &x, big_integer &y) {
+        big_integer next_x = m.a * x + m.b * y;
+        y = m.c * x + m.d * y;
+        x = next_x;
+    }
+
+    /*
+     * Subtracts the smaller of x and y as many times as possible keeping both
+     * at least bound, returns false when not even once, i.e. |x - y| < bound.
+     */
+    bool subtract_step(big_integer &x, big_integer &y, big_integer const &bound, hgcd_matrix &m) {
+        if (x >= y) {
+            if (x - y < bound) {
+                return false;
+            }
+            big_integer q = (x - bound) / y;
+            x -= q * y;
+            m.a -= q * m.c;
+            m.b -= q * m.d;
+        } else {
+            if (y - x < bound) {
+                return false;
+            }
+            big_integer q = (y - bound) / x;
+            y -= q * x;
+            m.c -= q * m.a;
+            m.d -= q * m.b;
+        }
+        return true;
+    }
+
+    // Lehmer's steps while the remainders stay at least 2^s, then exact ones
+    hgcd_matrix hgcd_basecase(big_integer &x, big_integer &y, size_t s) {
+        hgcd_matrix m = identity;
+        if (x < y) {
+            std::swap(x, y);
+            m = {0, 1, 1, 0};
+        }
+
+        if (x.digits_qty() > 2) {
+            euclid_state st(x, y);
+            cofactors cx(x.digits_qty() + 2, true), cy(x.digits_qty() + 2, false);
+            for (lehmer_matrix l = lehmer_step(st, true, s); l.b != 0; l = lehmer_step(st, true, s)) {
+                lehmer_apply(st, l, &cx, &cy);
+            }
+            x = st.first();
+            y = st.second();
+            m = compose({cx.first(), cy.first(), cx.second(), cy.second()}, m);
+        }
+
+        big_integer bound = big_integer(1) << (int32_t) s;
+        while (subtract_step(x, y, bound, m)) {
+        }
+        return m;
+    }
+
+    hgcd_matrix hgcd(big_integer &x, big_integer &y, size_t s);
+
+    /*
+     * Reduces x >> p and y >> p and applies the same matrix to x and y.
+     * By Möller's lemma the results stay above 2^(p + s0 - 1), s0 is the bound
+     * of the reduction of the high parts.
+     */
+    hgcd_matrix hgcd_high(big_integer &x, big_integer &y, size_t p) {
+        big_integer x0 = x >> (int32_t) p, y0 = y >> (int32_t) p;
+        size_t s0 = std::max(bit_length(x0), bit_length(y0)) / 2 + 1;
+        big_integer bound = big_integer(1) << (int32_t) s0;
+        if (x0 < bound || y0 < bound) {
+            return identity;
+        }
+
+        hgcd_matrix m = hgcd(x0, y0, s0);
+        big_integer x1 = x - ((x >> (int32_t) p) << (int32_t) p), y1 = y - ((y >> (int32_t) p) << (int32_t) p);
+        transform(m, x1, y1);
+        x = (x0 << (int32_t) p) + x1;
+        y = (y0 << (int32_t) p) + y1;
+        return m;
+    }
+
+    /*
+     * Möller's half-GCD: reduces x, y >= 2^s by steps keeping both of them at
+     * least 2^s until |x - y| < 2^s and returns the matrix of the steps. Bit lengths
+     * of x and y must be less than 2s. Two recursive calls on halves of the length
+     * and matrix products make it O(M(n) log n).
+     */
+    hgcd_matrix hgcd(big_integer &x, big_integer &y, size_t s) {
+        if (std::max(x.digits_qty(), y.digits_qty()) < HGCD_THRESHOLD) {
+            return hgcd_basecase(x, y, s);
+        }
+
+        big_integer bound = big_integer(1) << (int32_t) s;
+        hgcd_matrix m = hgcd_high(x, y, s);
+        subtract_step(x, y, bound, m);
+        size_t n = std::max(bit_length(x), bit_length(y));
+        m = compose(hgcd_high(x, y, 2 * s - n), m);
+        while (subtract_step(x, y, bound, m)) {
+        }
+        return m;
+    }
+
+    // Halves x >= y with half-GCD and a division step while y is long enough
+    void hgcd_reduce(big_integer &x, big_integer &y, hgcd_matrix *cofactors) {
+        size_t threshold = (cofactors == nullptr ? GCD_HGCD_THRESHOLD : GCDEXT_HGCD_THRESHOLD);
+        while (y.digits_qty() >= threshold) {
+            size_t s = bit_length(x) / 2 + 1;
+            if (y >= big_integer(1) << (int32_t) s) {
+                hgcd_matrix m = hgcd(x, y, s);
+                if (x < y) {
+                    std::swap(x, y);
+                    m = compose({0, 1, 1, 0}, m);
+                }
+                if (cofactors != nullptr) {
+                    *cofactors = compose(m, *cofactors);
+                }
+            }
+
+            big_integer q = x / y;
+            big_integer r = x - q * y;
+            x = y;
+            y = r;
+            if (cofactors != nullptr) {
+                *cofactors = compose({0, 1, 1, -q}, *cofactors);
+            }
+        }
+    }
+}
+
+big_integer gcd(big_integer const &a, big_integer const &b) {
+    big_integer x = (a < 0 ? -a : a), y = (b < 0 ? -b : b);
+    if (x < y) {
+        std::swap(x, y);
+    }
+    hgcd_reduce(x, y, nullptr);
+    if (y == 0) {
+        return x;
+    }
+
+    if (x.digits_qty() > 2) {
+        euclid_state s(x, y);
+        lehmer_reduce(s, nullptr, nullptr);
+        if (s.yn == 0) {
+            return s.first();
+        }
+        x = s.second();
+        y = s.first() % x;
+    }
+    return binary_gcd(to_word(x), to_word(y));
+}
+
+big_integer lcm(big_integer const &a, big_integer const &b) {
+    if (a == 0 || b == 0) {
+        return 0;
+    }
+    big_integer res = divexact(a, gcd(a, b)) * b;
+    return (res < 0 ? -res : res);
+}
+
+big_integer gcdext(big_integer const &a, big_integer const &b, big_integer &s, big_integer &t) {
+    big_integer x = (a < 0 ? -a : a), y = (b < 0 ? -b : b);
+    bool swapped = x < y;
+    if (swapped) {
+        std::swap(x, y);
+    }
+
+    // x = m.a * x0 + m.b * y0, y = m.c * x0 + m.d * y0
+    hgcd_matrix m = identity;
+    hgcd_reduce(x, y, &m);
+    if (x.digits_qty() > 2 && y != 0) {
+        euclid_state st(x, y);
+        cofactors cx(x.digits_qty() + 2, true), cy(x.digits_qty() + 2, false);
+        lehmer_reduce(st, &cx, &cy);
+        x = st.first();
+        y = st.second();
+        m = compose({cx.first(), cy.first(), cx.second(), cy.second()}, m);
+    }
+    while (y != 0) {
+        big_integer q = x / y;
+        big_integer r = x - q * y;
+        x = y;
+        y = r;
+        transform({0, 1, 1, -q}, m.a, m.c);
+        transform({0, 1, 1, -q}, m.b, m.d);
+    }
+
+    s = (swapped ? m.b : m.a);
+    t = (swapped ? m.a : m.b);
+    if (a < 0) {
+        s = -s;
+    }
+    if (b < 0) {
+        t = -t;
+    }
+    return x;
+}
+
+// Only the cofactor of a is tracked: Lehmer's steps over digits, then machine words
+bool inverse_mod(big_integer const &a, big_integer const &m, big_integer &inv) {
+    assert (m > 0);
+
+    big_integer x = m, y = a % m;
+    if (y < 0) {
+        y += m;
+    }
+    if (m.digits_qty() >= GCDEXT_HGCD_THRESHOLD) {
+        big_integer s, t;
+        if (gcdext(x, y, s, t) != 1) {
+            return false;
+        }
+        inv = (t < 0 ? t + m : t);
+        return true;
+    }
+
+    // x = u * a, y = v * a (mod m)
+    big_integer u = 0, v = 1;
+    if (x.digits_qty() > 2 && y != 0) {
+        euclid_state st(x, y);
+        cofactors cy(x.digits_qty() + 2, false);
+        lehmer_reduce(st, nullptr, &cy);
+        x = st.first();
+        y = st.second();
+        u = cy.first();
+        v = cy.second();
+        if (x.digits_qty() > 2 && y != 0) {
+            big_integer q = x / y;
+            x -= q * y;
+            u -= q * v;
+            std::swap(x, y);
+            std::swap(u, v);
+        }
+    }
+
+    uint64_t xw = to_word(x), yw = to_word(y);
+    while (yw != 0) {
+        uint64_t q = xw / yw;
+        uint64_t r = xw - q * yw;
+        xw = yw;
+        yw = r;
+        big_integer w = u - v * q;
+        u = v;
+        v = w;
+    }
+
+    if (xw != 1 || x.digits_qty() > 2) {
+        return false;
+    }
+    inv = (u < 0 ? u + m : u);
+    return true;
+}
+
+/*
+ * Binary algorithm: factors of two are stripped with (2 / n) = (-1)^((n^2 - 1) / 8),
+ * the smaller odd number is subtracted from the larger one after the reciprocity
+ * law. Digit arrays are used until both numbers fit into machine words.
+ */
+int jacobi(big_integer const &a, big_integer const &n) {
+    assert (n > 0 && (n.get_digit(0, false) & 1) == 1);
+
+    big_integer r = a % n;
+    if (r < 0) {
+        r += n;
+    }
+    size_t len = n.digits_qty();
+    std::vector<uint32_t> x(len), y(len);
+    to_digits(r, x.data(), len);
+    to_digits(n, y.data(), len);
+    size_t xn = (r == 0 ? 0 : r.digits_qty()), yn = len;
+
+    int t = 1;
+    while (xn > 2 || yn > 2) {
+        if (xn == 0) {
+            return 0;
+        }
+
+        size_t zeros = 0;
+        while (x[zeros] == 0) {
+            ++zeros;
+        }
+        unsigned bits = __builtin_ctz(x[zeros]);
+        if (zeros > 0) {
+            std::copy(x.begin() + zeros, x.begin() + xn, x.begin());
+            xn -= zeros;
+        }
+        if (bits > 0) {
+            rshift(x.data(), x.data(), xn, bits);
+            xn -= (x[xn - 1] == 0);
+        }
+        if (((LOG2_BASE * zeros + bits) & 1) == 1 && ((y[0] & 7) == 3 || (y[0] & 7) == 5)) {
+            t = -t;
+        }
+
+        if (cmp(x.data(), xn, y.data(), yn) < 0) {
+            std::swap(x, y);
+            std::swap(xn, yn);
+            if ((x[0] & 3) == 3 && (y[0] & 3) == 3) {
+                t = -t;
+            }
+        }
+        sub(x.data(), x.data(), xn, y.data(), yn);
+        while (xn > 0 && x[xn - 1] == 0) {
+            --xn;
+        }
+    }
+
+    uint64_t xw = (xn > 0 ? x[0] : 0) | (xn > 1 ? (uint64_t) x[1] << LOG2_BASE : 0);
+    uint64_t yw = y[0] | (yn > 1 ? (uint64_t) y[1] << LOG2_BASE : 0);
+    while (xw != 0) {
+        int bits = __builtin_ctzll(xw);
+        xw >>= bits;
+        if ((bits & 1) == 1 && ((yw & 7) == 3 || (yw & 7) == 5)) {
+            t = -t;
+        }
+        if (xw < yw) {
+            std::swap(xw, yw);
+            if ((xw & 3) == 3 && (yw & 3) == 3) {
+                t = -t;
+            }
+        }
+        xw -= yw;
+    }
+    return (yw == 1 ? t : 0);
+}
+
+namespace {
+    // Square root of a machine word, the double one is off by at most one
+    uint64_t sqrt_word(uint64_t a) {
+        uint64_t s = std::min((uint64_t) std::sqrt((double) a), (uint64_t) UINT32_MAX);
+        while (s * s > a) {
+            --s;
+        }
+        while (s < UINT32_MAX && (s + 1) * (s + 1) <= a) {
+            ++s;
+        }
+        return s;
+    }
+
+    big_integer low_bits(big_integer const &a, size_t k) {
+        return a - ((a >> (int32_t) k) << (int32_t) k);
+    }
+
+    /*
+     * Zimmermann's Karatsuba square root: a is split into quarters of k bits,
+     * the root of the upper half gives the upper half of the root, and the lower
+     * one is a quotient by twice of it, wrong by at most one. a is shifted
+     * by an even number of bits first, so that its highest quarter is at least 2^(k - 2).
+     */
+    big_integer sqrt_rem(big_integer const &a, big_integer &rem) {
+        size_t bits = bit_length(a);
+        if (bits <= 2 * LOG2_BASE) {
+            uint64_t w = to_word(a), s = sqrt_word(w);
+            rem = w - s * s;
+            return s;
+        }
+
+        size_t k = (bits + 3) / 4;
+        auto c = (int32_t) (4 * k - bits) / 2;
+        big_integer n = a << 2 * c;
+
+        big_integer r1;
+        big_integer s1 = sqrt_rem(n >> (int32_t) (2 * k), r1);
+        big_integer q, u;
+        divmod((r1 << (int32_t) k) + low_bits(n >> (int32_t) k, k), s1 << 1, q, u);
+        big_integer s = (s1 << (int32_t) k) + q;
+        big_integer r = (u << (int32_t) k) + low_bits(n, k) - q * q;
+        if (r < 0) {
+            r += (s << 1) - 1;
+            --s;
+        }
+
+        if (c > 0) {
+            s >>= c;
+            r = a - s * s;
+        }
+        rem = r;
+        return s;
+    }
+
+    /*
+     * Newton's iteration x <- ((k - 1) * x + a / x^(k - 1)) / k decreases from any
+     * upper bound to the root. The bound comes from the root of the upper half of
+     * the digits, so every level only doubles the precision, or from a double.
+     */
+    big_integer root_newton(big_integer const &a, uint32_t k) {
+        size_t bits = bit_length(a), root_bits = (bits + k - 1) / k;
+        big_integer x;
+        if (root_bits <= 40) {
+            size_t drop = (bits > 53 ? bits - 53 : 0);
+            double top = (double) to_word(a >> (int32_t) drop) + 1;
+            double root = std::exp2((std::log2(top) + (double) drop) / k);
+            x = (uint64_t) (root * (1 + 1e-9)) + 2;
+        } else {
+            size_t h = root_bits / 2;
+            x = (root_newton(a >> (int32_t) (k * h), k) + 1) << (int32_t) h;
+        }
+
+        while (true) {
+            big_integer y = (x * (k - 1) + a / pow(x, k - 1)) / k;
+            if (y >= x) {
+                return x;
+            }
+            x = y;
+        }
+    }
+}
+
+big_integer isqrt(big_integer const &a) {
+    big_integer rem;
+    return isqrt_rem(a, rem);
+}
+
+big_integer isqrt_rem(big_integer const &a, big_integer &rem) {
+    assert (a >= 0);
+    return sqrt_rem(a, rem);
+}
+
+big_integer iroot(big_integer const &a, uint32_t k) {
+    assert (k > 0 && (a >= 0 || k % 2 == 1));
+
+    if (a < 0) {
+        return -iroot(-a, k);
+    }
+    if (k == 1 || a < 2) {
+        return a;
+    }
+    if (k == 2) {
+        return isqrt(a);
+    }
+    if (k >= bit_length(a)) {
+        return 1;
+    }
+    return root_newton(a, k);
+}
+
+// Squares modulo 64, 63, 65 and 11 let through less than 1% of other numbers
+bool is_perfect_square(big_integer const &a) {
+    if (a < 0) {
+        return false;
+    }
+    if (((0x202021202030213ull >> (a.get_digit(0, false) & 63)) & 1) == 0) {
+        return false;
+    }
+
+    uint32_t r = (a % 45045u).get_digit(0, false);
+    if (((0x402483012450293ull >> (r % 63)) & 1) == 0 || ((0x23bull >> (r % 11)) & 1) == 0) {
+        return false;
+    }
+    if (r % 65 != 64 && ((0x218a019866014613ull >> (r % 65)) & 1) == 0) {
+        return false;
+    }
+
+    big_integer rem;
+    isqrt_rem(a, rem);
+    return rem == 0;
+}
+
+namespace {
+    uint32_t pow_mod_word(uint64_t a, uint64_t e, uint64_t m) {
+        uint64_t res = 1;
+        for (a %= m; e > 0; e >>= 1, a = a * a % m) {
+            if (e & 1) {
+                res = res * a % m;
+            }
+        }
+        return (uint32_t) res;
+    }
+
+    bool is_prime_word(uint32_t n) {
+        for (uint32_t d = 2; d * d <= n; ++d) {
+            if (n % d == 0) {
+                return false;
+            }
+        }
+        return n >= 2;
+    }
+
+    /*
+     * a = b^p for prime p is checked modulo a few primes q = 1 (mod p) first,
+     * only 1 / p of residues are p-th powers there.
+     */
+    bool is_power(big_integer const &a, uint32_t p) {
+        if (p == 2) {
+            return is_perfect_square(a);
+        }
+
+        size_t checked = 0;
+        for (uint32_t q = 2 * p + 1; checked < 4 && q < (1u << 16); q += 2 * p) {
+            if (!is_prime_word(q)) {
+                continue;
+            }
+            ++checked;
+            uint32_t r = (a % q).get_digit(0, false);
+            if (r != 0 && pow_mod_word(r, (q - 1) / p, q) != 1) {
+                return false;
+            }
+        }
+        return pow(iroot(a, p), p) == a;
+    }
+}
+
+// Only prime exponents matter, they divide the number of trailing zero bits
+bool is_perfect_power(big_integer const &a) {
+    if (a == 0 || a == 1 || a == -1) {
+        return true;
+    }
+
+    big_integer m = (a < 0 ? -a : a);
+    size_t zeros = 0;
+    while (get_bit(m, zeros) == 0) {
+        ++zeros;
+    }
+
+    size_t bits = bit_length(m);
+    for (uint32_t p = (a < 0 ? 3 : 2); p <= bits; ++p) {
+        if (!is_prime_word(p) || (zeros > 0 && zeros % p != 0)) {
+            continue;
+        }
+        if (is_power(m, p)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace {
+    // Sieve of Eratosthenes over odd numbers
+    std::vector<uint32_t> primes_up_to(uint32_t n) {
+        std::vector<uint32_t> res;
+        if (n < 2) {
+            return res;
+        }
+        res.push_back(2);
+        std::vector<bool> composite(n / 2 + 1);
+        for (uint64_t i = 3; i <= n; i += 2) {
+            if (!composite[i / 2]) {
+                res.push_back((uint32_t) i);
+                for (uint64_t j = i * i; j <= n; j += 2 * i) {
+                    composite[j / 2] = true;
+                }
+            }
+        }
+        return res;
+    }
+
+    std::vector<uint32_t> const &small_primes() {
+        static const std::vector<uint32_t> primes = primes_up_to((1u << 16) - 1);
+        return primes;
+    }
+
+    // Primes below 1000 checked by trial division
+    const size_t TRIAL_PRIMES = 168;
+
+    // Returns 1 for a prime, 0 for a composite and -1 if n is too large to tell
+    int trial_division(big_integer const &n) {
+        std::vector<uint32_t> const &primes = small_primes();
+        for (size_t i = 0; i < TRIAL_PRIMES;) {
+            // Several primes at once, their product fits into a digit
+            uint64_t product = 1;
+            size_t j = i;
+            while (j < TRIAL_PRIMES && product * primes[j] <= UINT32_MAX) {
+                product *= primes[j++];
+            }
+            uint32_t r = (n % (uint32_t) product).get_digit(0, false);
+            for (; i < j; ++i) {
+                if (r % primes[i] == 0) {
+                    return n == primes[i];
+                }
+            }
+        }
+        uint32_t last = primes[TRIAL_PRIMES - 1];
+        return (n < (uint64_t) last * last ? 1 : -1);
+    }
+
+    /*
+     * Strong probable prime tests modulo odd n > 2 over raw Montgomery residues.
+     * Buffers are allocated once, so rounds never allocate.
+     */
+    struct prime_tester {
+        montgomery_context ctx;
+        size_t n;
+        big_integer d;
+        size_t s;
+        std::vector<uint32_t> mod, one, minus_one, base, x, scratch, workspace;
+
+        explicit prime_tester(big_integer const &m)
+                : ctx(m), n(ctx.size()), s(0), mod(n), one(ctx.one(), ctx.one() + n), minus_one(n),
+                  base(n), x(n), scratch(ctx.scratch_size()) {
+            to_digits(m, mod.data(), n);
+            sub_n(minus_one.data(), mod.data(), one.data(), n);
+            // m - 1 = d * 2^s with odd d
+            while (get_bit(m, s + 1) == 0) {
+                ++s;
+            }
+            ++s;
+            d = (m - 1) >> (int32_t) s;
+            workspace.resize(sliding_window_workspace(n, d));
+        }
+
+        bool equal(std::vector<uint32_t> const &a, std::vector<uint32_t> const &b) const {
+            return cmp_n(a.data(), b.data(), n) == 0;
+        }
+
+        // base is in Montgomery form
+        bool miller_rabin() {
+            sliding_window_pow(ctx, x.data(), base.data(), one.data(), d, scratch.data(), workspace.data());
+            if (equal(x, one) || equal(x, minus_one)) {
+                return true;
+            }
+            for (size_t i = 1; i < s; ++i) {
+                ctx.sqr(x.data(), x.data(), scratch.data());
+                if (equal(x, minus_one)) {
+                    return true;
+                }
+                if (equal(x, one)) {
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        bool base_2() {
+            if (add_n(base.data(), one.data(), one.data(), n) != 0 || cmp_n(base.data(), mod.data(), n) >= 0) {
+                sub_n(base.data(), base.data(), mod.data(), n);
+            }
+            return miller_rabin();
+        }
+
+        // Random digits below m are the Montgomery form of a random residue
+        bool random_base(std::mt19937 &gen) {
+            do {
+                for (size_t i = 0; i + 1 < n; ++i) {
+                    base[i] = gen();
+                }
+                base[n - 1] = gen() % mod[n - 1];
+            } while (cmp_n(base.data(), mod.data(), n) >= 0 || equal(base, one) || equal(base, minus_one) ||
+                     std::all_of(base.begin(), base.end(), [](uint32_t digit) { return digit == 0; }));
+            return miller_rabin();
+        }
+
+        void add_mod(uint32_t *r, uint32_t const *a, uint32_t const *b) const {
+            if (add_n(r, a, b, n) != 0 || cmp_n(r, mod.data(), n) >= 0) {
+                sub_n(r, r, mod.data(), n);
+            }
+        }
+
+        void sub_mod(uint32_t *r, uint32_t const *a, uint32_t const *b) const {
+            if (sub_n(r, a, b, n) != 0) {
+                add_n(r, r, mod.data(), n);
+            }
+        }
+
+        // r = a / 2, odd a is made even by adding m
+        void half_mod(uint32_t *r, uint32_t const *a) const {
+            uint32_t carry = 0;
+            if ((a[0] & 1) == 1) {
+                carry = add_n(r, a, mod.data(), n);
+                a = r;
+            }
+            rshift(r, a, n, 1);
+            r[n - 1] |= carry << (LOG2_BASE - 1);
+        }
+
+        /*
+         * Strong Lucas test with P = 1, Q = (1 - D) / 4, where D is the first of
+         * 5, -7, 9, -11, ... with Jacobi symbol (D / m) = -1. For m + 1 = d' * 2^s'
+         * m passes when U(d') = 0 or V(d' * 2^r) = 0 for some r < s' (mod m).
+         */
+        bool strong_lucas(big_integer const &m) {
+            if (is_perfect_square(m)) {
+                return false;
+            }
+            int64_t dd = 5;
+            while (true) {
+                int j = jacobi(dd, m);
+                if (j == -1) {
+                    break;
+                }
+                if (j == 0 && m != (dd < 0 ? -dd : dd)) {
+                    return false;
+                }
+                dd = (dd > 0 ? -dd - 2 : -dd + 2);
+            }
+
+            std::vector<uint32_t> u(one), v(one), qk(n), q(n), dm(n), t(n), t2(n);
+            to_digits(ctx.to_montgomery((1 - dd) / 4), q.data(), n);
+            to_digits(ctx.to_montgomery(dd), dm.data(), n);
+            qk = q;
+
+            size_t r = 0;
+            while (get_bit(m, r + 1) == 1) {
+                ++r;
+            }
+            ++r;
+            big_integer e = (m + 1) >> (int32_t) r;
+
+            for (size_t i = bit_length(e) - 1; i-- > 0;) {
+                // U(2k) = U(k) V(k), V(2k) = V(k)^2 - 2 Q^k
+                ctx.mul(u.data(), u.data(), v.data(), scratch.data());
+                ctx.sqr(v.data(), v.data(), scratch.data());
+                add_mod(t.data(), qk.data(), qk.data());
+                sub_mod(v.data(), v.data(), t.data());
+                ctx.sqr(qk.data(), qk.data(), scratch.data());
+                if (get_bit(e, i) == 1) {
+                    // U(k + 1) = (U(k) + V(k)) / 2, V(k + 1) = (D U(k) + V(k)) / 2
+                    add_mod(t.data(), u.data(), v.data());
+                    ctx.mul(t2.data(), dm.data(), u.data(), scratch.data());
+                    add_mod(t2.data(), t2.data(), v.data());
+                    half_mod(u.data(), t.data());
+                    half_mod(v.data(), t2.data());
+                    ctx.mul(qk.data(), qk.data(), q.data(), scratch.data());
+                }
+            }
+
+            auto zero = [&](std::vector<uint32_t> const &a) {
+                return std::all_of(a.begin(), a.end(), [](uint32_t digit) { return digit == 0; });
+            };
+            if (zero(u)) {
+                return true;
+            }
+            for (size_t k = 0; k < r; ++k) {
+                if (zero(v)) {
+                    return true;
+                }
+                ctx.sqr(v.data(), v.data(), scratch.data());
+                add_mod(t.data(), qk.data(), qk.data());
+                sub_mod(v.data(), v.data(), t.data());
+                ctx.sqr(qk.data(), qk.data(), scratch.data());
+            }
+            return false;
+        }
+    };
+
+    bool probable_prime_after_sieve(big_integer const &n, size_t rounds) {
+        prime_tester tester(n);
+        if (!tester.base_2() || !tester.strong_lucas(n)) {
+            return false;
+        }
+        if (rounds == 0) {
+            return true;
+        }
+        // Seeded from the system, bases that follow from n could be targeted by a crafted composite
+        std::random_device device;
+        std::mt19937 gen(device());
+        for (size_t i = 0; i < rounds; ++i) {
+            if (!tester.random_base(gen)) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+bool is_probable_prime(big_integer const &n, size_t rounds) {
+    if (n < 2) {
+        return false;
+    }
+    int trial = trial_division(n);
+    if (trial != -1) {
+        return trial == 1;
+    }
+    return probable_prime_after_sieve(n, rounds);
+}
+
+/*
+ * Odd candidates of a window are sieved by primes below 2^16 at once:
+ * for start = r (mod p) the multiples of p are start + 2i for i = -r / 2 (mod p).
+ */
+big_integer next_prime(big_integer const &n) {
+    if (n < 2) {
+        return 2;
+    }
+    big_integer start = n + 1 + (n.get_digit(0, false) & 1);
+    if (start < (uint64_t) 1 << 32) {
+        while (!is_probable_prime(start)) {
+            start += 2;
+        }
+        return start;
+    }
+
+    std::vector<uint32_t> const &primes = small_primes();
+    const size_t window = 8 * bit_length(n) + 64;
+    std::vector<bool> sieve(window);
+    while (true) {
+        std::fill(sieve.begin(), sieve.end(), false);
+        for (size_t i = 1; i < primes.size(); ++i) {
+            uint64_t p = primes[i], r = (start % (uint32_t) p).get_digit(0, false);
+            for (uint64_t j = (p - r) % p * ((p + 1) / 2) % p; j < window; j += p) {
+                sieve[j] = true;
+            }
+        }
+
+        for (size_t i = 0; i < window; ++i) {
+            if (!sieve[i] && probable_prime_after_sieve(start + 2 * i, 0)) {
+                return start + 2 * i;
+            }
+        }
+        start += 2 * window;
+    }
+}
+
+namespace {
+    // Runs of 16 words are multiplied one word at a time, the runs then go to the balanced product
+    big_integer word_product(std::vector<uint32_t> const &factors) {
+        std::vector<big_integer> runs;
+        for (size_t i = 0; i < factors.size(); i += 16) {
+            big_integer run = 1;
+            for (size_t j = i; j < std::min(i + 16, factors.size()); ++j) {
+                run *= factors[j];
+            }
+            runs.push_back(run);
+        }
+        return product(std::move(runs));
+    }
+
+    // Product of p^e over primes p with exponents e, squarings are shared by all of them
+    big_integer from_exponents(std::vector<uint32_t> const &primes, std::vector<uint32_t> const &exponents) {
+        uint32_t top = 0;
+        for (uint32_t e : exponents) {
+            top = std::max(top, e);
+        }
+
+        big_integer res = 1;
+        std::vector<uint32_t> factors;
+        for (size_t bit = 31; bit != (size_t) (-1); --bit) {
+            if ((top >> bit) == 0) {
+                continue;
+            }
+            res *= res;
+            factors.clear();
+            for (size_t i = 0; i < primes.size(); ++i) {
+                if ((exponents[i] >> bit) & 1) {
+                    factors.push_back(primes[i]);
+                }
+            }
+            res *= word_product(factors);
+        }
+        return res;
+    }
+
+    // Exponent of prime p in n! by Legendre's formula
+    uint32_t factorial_exponent(uint64_t n, uint64_t p) {
+        uint32_t e = 0;
+        for (n /= p; n > 0; n /= p) {
+            e += (uint32_t) n;
+        }
+        return e;
+    }
+
+    /*
+     * Odd part of n! / (n / 2)!^2: odd prime p enters it in power of the number of
+     * odd floor(n / p^i), and that power never exceeds n.
+     */
+    big_integer odd_swing(uint32_t n, std::vector<uint32_t> const &primes) {
+        std::vector<uint32_t> factors;
+        for (size_t i = 1; i < primes.size() && primes[i] <= n; ++i) {
+            uint32_t p = primes[i], power = 1;
+            for (uint32_t q = n / p; q > 0; q /= p) {
+                if (q & 1) {
+                    power *= p;
+                }
+            }
+            if (power > 1) {
+                factors.push_back(power);
+            }
+        }
+        return word_product(factors);
+    }
+
+    // Odd part of n! is odd part of (n / 2)! squared times odd part of the swing
+    big_integer odd_factorial(uint32_t n, std::vector<uint32_t> const &primes) {
+        if (n < 3) {
+            return 1;
+        }
+        big_integer half = odd_factorial(n / 2, primes);
+        return half * half * odd_swing(n, primes);
+    }
+}
+
+// Luschny's prime swing, powers of two are gathered into one shift
+big_integer factorial(uint32_t n) {
+    if (n <= 20) {
+        uint64_t res = 1;
+        for (uint32_t i = 2; i <= n; ++i) {
+            res *= i;
+        }
+        return res;
+    }
+    std::vector<uint32_t> primes = primes_up_to(n);
+    return odd_factorial(n, primes) << (int32_t) (n - __builtin_popcount(n));
+}
+
+// (2m)!! = 2^m m!, (2m + 1)!! = (2m + 1)! / (2^m m!) has prime exponents of the difference
+big_integer double_factorial(uint32_t n) {
+    if (n % 2 == 0) {
+        return factorial(n / 2) << (int32_t) (n / 2);
+    }
+
+    std::vector<uint32_t> primes = primes_up_to(n), exponents(primes.size());
+    for (size_t i = 1; i < primes.size(); ++i) {
+        exponents[i] = factorial_exponent(n, primes[i]) - factorial_exponent(n / 2, primes[i]);
+    }
+    return from_exponents(primes, exponents);
+}
+
+big_integer primorial(uint32_t n) {
+    std::vector<uint32_t> primes = primes_up_to(n);
+    return word_product(primes);
+}
+
+/*
+ * Exponent of p in the binomial coefficient is the number of borrows in n - k
+ * in base p (Kummer), small k go through products of exact quotients.
+ */
+big_integer binomial(uint64_t n, uint64_t k) {
+    if (k > n) {
+        return 0;
+    }
+    k = std::min(k, n - k);
+    if (k <= 64 || n > UINT32_MAX) {
+        big_integer res = 1;
+        for (uint64_t i = 0; i < k; ++i) {
+            res *= n - i;
+            res = i < UINT32_MAX ? divexact_by_uint32(res, (uint32_t) (i + 1)) : divexact(res, i + 1);
+        }
+        return res;
+    }
+
+    std::vector<uint32_t> primes = primes_up_to((uint32_t) n), exponents(primes.size());
+    for (size_t i = 0; i < primes.size(); ++i) {
+        exponents[i] = factorial_exponent(n, primes[i]) - factorial_exponent(k, primes[i]) -
+                       factorial_exponent(n - k, primes[i]);
+    }
+    return from_exponents(primes, exponents);
+}
+
+namespace {
+    // Pair F(n), F(n - 1) from F(2k + 1) = 4 F(k)^2 - F(k - 1)^2 + 2 (-1)^k,
+    // F(2k - 1) = F(k)^2 + F(k - 1)^2 and F(2k) = F(2k + 1) - F(2k - 1)
+    void fibonacci_pair(uint64_t n, big_integer &f, big_integer &g) {
+        f = n == 0 ? 0 : 1;
+        g = n == 0 ? 1 : 0;
+        if (n <= 1) {
+            return;
+        }
+        size_t top = 63 - __builtin_clzll(n);
+        for (size_t i = top; i-- > 0;) {
+            big_integer f2 = f * f, g2 = g * g;
+            big_integer odd = (f2 << 2) - g2 + (((n >> (i + 1)) & 1) == 1 ? -2 : 2);
+            big_integer even = odd - f2 - g2;
+            if (((n >> i) & 1) == 1) {
+                f = odd;
+                g = even;
+            } else {
+                f = even;
+                g = f2 + g2;
+            }
+        }
+    }
+
+    big_integer to_form(montgomery_context const &ctx, big_integer const &a) {
+        return ctx.to_montgomery(a);
+    }
+
+    big_integer to_form(barrett_context const &ctx, big_integer const &a) {
+        return ctx.reduce(a);
+    }
+
+    big_integer from_form(montgomery_context const &ctx, big_integer const &a) {
+        return ctx.from_montgomery(a);
+    }
+
+    big_integer from_form(barrett_context const &, big_integer const &a) {
+        return a;
+    }
+
+    /*
+     * Ladder over U(k), U(k + 1) that never halves, so the modulus may be even:
+     * U(2k) = U(k) (2 U(k + 1) - p U(k)), U(2k + 1) = U(k + 1)^2 - q U(k)^2
+     * and U(k + 2) = p U(k + 1) - q U(k), at the end V(n) = 2 U(n + 1) - p U(n).
+     * Residues stay in the context's form, coefficients of one digit multiply them
+     * directly, so a step costs two squarings and one multiplication.
+     */
+    template <typename Context>
+    void lucas_ladder(Context const &ctx, big_integer const &p, big_integer const &q, big_integer const &n,
+                      big_integer &u, big_integer &v) {
+        big_integer const &m = ctx.modulus();
+        big_integer p_form = to_form(ctx, p), q_form = to_form(ctx, q);
+
+        // x from (-m, 2m) to [0, m)
+        auto fit = [&m](big_integer x) -> big_integer {
+            if (x < 0) {
+                x += m;
+            } else if (x >= m) {
+                x -= m;
+            }
+            return x;
+        };
+        auto times = [&](big_integer const &x, big_integer const &c, big_integer const &c_form) -> big_integer {
+            if (c.digits_qty() > 1) {
+                return ctx.mul(x, c_form);
+            }
+            big_integer res = x * c % m;
+            return res < 0 ? res + m : res;
+        };
+
+        big_integer a = 0, b = to_form(ctx, 1);
+        for (size_t i = bit_length(n); i-- > 0;) {
+            big_integer even = ctx.mul(a, fit(fit(b + b) - times(a, p, p_form)));
+            big_integer odd = fit(ctx.sqr(b) - times(ctx.sqr(a), q, q_form));
+            if (get_bit(n, i) == 1) {
+                b = fit(times(odd, p, p_form) - times(even, q, q_form));
+                a = odd;
+            } else {
+                a = even;
+                b = odd;
+            }
+        }
+        u = from_form(ctx, a);
+        v = from_form(ctx, fit(fit(b + b) - times(a, p, p_form)));
+    }
+}
+
+big_integer fibonacci(uint64_t n) {
+    big_integer f, g;
+    fibonacci_pair(n, f, g);
+    return f;
+}
+
+// L(n) = F(n) + 2 F(n - 1)
+big_integer lucas(uint64_t n) {
+    big_integer f, g;
+    fibonacci_pair(n, f, g);
+    return f + (g << 1);
+}
+
+// Odd moduli go to Montgomery form, even ones to Barrett reduction
+void lucas_sequence(big_integer const &p, big_integer const &q, big_integer const &n, big_integer const &mod,
+                    big_integer &u, big_integer &v) {
+    assert (mod > 0 && n >= 0);
+
+    if (mod == 1) {
+        u = v = 0;
+    } else if ((mod.get_digit(0, false) & 1) == 1) {
+        lucas_ladder(montgomery_context(mod), p, q, n, u, v);
+    } else {
+        lucas_ladder(barrett_context(mod), p, q, n, u, v);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef BIGINT_NUMBER_THEORY_H
+#define BIGINT_NUMBER_THEORY_H
+
+#include "big_integer.h"
+
+// base^exp mod m for exp >= 0 and m > 0, result is from [0, m)
+big_integer pow_mod(big_integer const& base, big_integer const& exp, big_integer const& mod);
+// Same for secret exponents: timing and memory access depend only on
+// the number of digits in exp, m must be odd
+big_integer pow_mod_sec(big_integer const& base, big_integer const& exp, big_integer const& mod);
+
+// Greatest common divisor, it is never negative, gcd(0, 0) = 0
+big_integer gcd(big_integer const& a, big_integer const& b);
+// Least common multiple, it is never negative, lcm(a, 0) = 0
+big_integer lcm(big_integer const& a, big_integer const& b);
+// Returns g = gcd(a, b) and sets s, t so that a * s + b * t = g
+big_integer gcdext(big_integer const& a, big_integer const& b, big_integer& s, big_integer& t);
+
+// Integer square root floor(sqrt(a)) for a >= 0
+big_integer isqrt(big_integer const& a);
+// Same with rem = a - isqrt(a)^2
+big_integer isqrt_rem(big_integer const& a, big_integer& rem);
+// k-th root rounded towards zero for k > 0, a must be non-negative when k is even
+big_integer iroot(big_integer const& a, uint32_t k);
+bool is_perfect_square(big_integer const& a);
+// Whether a = b^k for some integer b and k >= 2, so 0, 1 and -1 are perfect powers
+bool is_perfect_power(big_integer const& a);
+
+/*
+ * Baillie-PSW test: trial division, strong Fermat test to base 2 and strong
+ * Lucas test with Selfridge's parameters, no composite passing it is known.
+ * rounds more Miller-Rabin tests may follow, their bases are drawn from
+ * a generator seeded by std::random_device and differ from call to call.
+ */
+bool is_probable_prime(big_integer const& n, size_t rounds = 0);
+// Smallest probable prime greater than n
+big_integer next_prime(big_integer const& n);
+
+// n!, n!! and the product of primes up to n, built from prime powers by balanced products
+big_integer factorial(uint32_t n);
+big_integer double_factorial(uint32_t n);
+big_integer primorial(uint32_t n);
+// Binomial coefficient, it is 0 for k > n
+big_integer binomial(uint64_t n, uint64_t k);
+
+// Fibonacci and Lucas numbers F(n) and L(n) by fast doubling, two squarings per bit of n
+big_integer fibonacci(uint64_t n);
+big_integer lucas(uint64_t n);
+/*
+ * Lucas sequences U(0) = 0, U(1) = 1, V(0) = 2, V(1) = p, X(k + 2) = p X(k + 1) - q X(k)
+ * taken modulo mod > 0 for n >= 0, u and v are set to U(n) and V(n) from [0, mod).
+ * fibonacci(n) is U(n) and lucas(n) is V(n) for p = 1, q = -1.
+ */
+void lucas_sequence(big_integer const& p, big_integer const& q, big_integer const& n, big_integer const& mod,
+                    big_integer& u, big_integer& v);
+
+// Sets inv from [0, m) so that a * inv = 1 (mod m) for m > 0, returns false if gcd(a, m) != 1
+bool inverse_mod(big_integer const& a, big_integer const& m, big_integer& inv);
+// Jacobi symbol (a / n) for odd n > 0, it is the Legendre symbol when n is prime
+int jacobi(big_integer const& a, big_integer const& n);
+
+#endif //BIGINT_NUMBER_THEORY_H
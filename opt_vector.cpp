@@ -62,6 +62,23 @@ uint32_t opt_vector<uint32_t>::back() const {
     return big_data->back();
 }
 
+template <>
+uint32_t *opt_vector<uint32_t>::data() {
+    if (is_small()) {
+        return &small_data;
+    }
+    make_unique();
+    return big_data->data();
+}
+
+template <>
+uint32_t const *opt_vector<uint32_t>::data() const {
+    if (is_small()) {
+        return &small_data;
+    }
+    return big_data->data();
+}
+
 template <>
 void opt_vector<uint32_t>::resize(size_t new_len) {
     if (is_small()) {
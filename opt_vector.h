@@ -34,6 +34,8 @@ public:
     T operator[](size_t pos) const;
     T &operator[](size_t pos);
     T back() const;
+    T *data();
+    T const *data() const;
 
     void resize(size_t new_len);
     void push_back(T new_val);
@@ -114,6 +116,23 @@ T opt_vector<T>::back() const {
     return big_data->back();
 }
 
+template <typename T>
+T *opt_vector<T>::data() {
+    if (is_small()) {
+        return &small_data;
+    }
+    make_unique();
+    return big_data->data();
+}
+
+template <typename T>
+T const *opt_vector<T>::data() const {
+    if (is_small()) {
+        return &small_data;
+    }
+    return big_data->data();
+}
+
 template <typename T>
 void opt_vector<T>::resize(size_t new_len) {
     if (is_small()) {
@@ -0,0 +1,135 @@
+#ifndef BIGINT_POWERING_H
+#define BIGINT_POWERING_H
+
+/*
+ * Exponentiation over any context with raw mul and sqr
+ * (montgomery_context, barrett_context).
+ * Residues have ctx.size() digits, scratch has ctx.scratch_size() digits.
+ */
+
+#include "big_integer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+inline size_t bit_length(big_integer const& e) {
+    size_t n = e.digits_qty();
+    uint32_t top = e.get_digit(n - 1, false);
+    size_t res = 32 * (n - 1);
+    while (top != 0) {
+        ++res;
+        top >>= 1;
+    }
+    return res;
+}
+
+inline uint32_t get_bit(big_integer const& e, size_t pos) {
+    return (e.get_digit(pos / 32, false) >> (pos % 32)) & 1;
+}
+
+// Longer exponents pay for bigger tables with fewer multiplications
+inline size_t window_size(size_t bits) {
+    static const size_t thresholds[] = {7, 25, 81, 241, 673, 1793};
+    size_t k = 1;
+    while (k <= 6 && bits > thresholds[k - 1]) {
+        ++k;
+    }
+    return k;
+}
+
+// Digits of workspace for sliding_window_pow with n-digit residues
+inline size_t sliding_window_workspace(size_t n, big_integer const& e) {
+    return (n << (window_size(bit_length(e)) - 1)) + n;
+}
+
+// Left-to-right sliding window: every window starts and ends with bit 1,
+// so only odd powers x, x^3, ..., x^(2^k - 1) are tabulated in the workspace
+template <typename Context>
+void sliding_window_pow(Context const& ctx, uint32_t *res, uint32_t const *x, uint32_t const *one,
+                        big_integer const& e, uint32_t *scratch, uint32_t *workspace) {
+    size_t n = ctx.size(), bits = bit_length(e), k = window_size(bits);
+    std::copy(one, one + n, res);
+    if (bits == 0) {
+        return;
+    }
+
+    uint32_t *table = workspace, *x2 = workspace + (n << (k - 1));
+    std::copy(x, x + n, table);
+    ctx.sqr(x2, x, scratch);
+    for (size_t i = 1; i < ((size_t) 1 << (k - 1)); ++i) {
+        ctx.mul(&table[i * n], &table[(i - 1) * n], x2, scratch);
+    }
+
+    bool started = false;
+    for (size_t i = bits - 1; i != (size_t) (-1);) {
+        if (get_bit(e, i) == 0) {
+            ctx.sqr(res, res, scratch);
+            --i;
+            continue;
+        }
+
+        size_t j = (i + 1 >= k ? i + 1 - k : 0);
+        while (get_bit(e, j) == 0) {
+            ++j;
+        }
+        size_t value = 0;
+        for (size_t pos = i; pos != j - 1; --pos) {
+            value = (value << 1) | get_bit(e, pos);
+        }
+
+        if (started) {
+            for (size_t pos = i; pos != j - 1; --pos) {
+                ctx.sqr(res, res, scratch);
+            }
+            ctx.mul(res, res, &table[(value >> 1) * n], scratch);
+        } else {
+            std::copy(&table[(value >> 1) * n], &table[(value >> 1) * n] + n, res);
+            started = true;
+        }
+        i = j - 1;
+    }
+}
+
+template <typename Context>
+void sliding_window_pow(Context const& ctx, uint32_t *res, uint32_t const *x, uint32_t const *one,
+                        big_integer const& e, uint32_t *scratch) {
+    std::vector<uint32_t> workspace(sliding_window_workspace(ctx.size(), e));
+    sliding_window_pow(ctx, res, x, one, e, scratch, workspace.data());
+}
+
+// Fixed windows over all 32 * digits_qty() bits, every table entry is read
+// on each lookup, so neither timing nor memory access depends on exponent bits
+template <typename Context>
+void fixed_window_pow(Context const& ctx, uint32_t *res, uint32_t const *x, uint32_t const *one,
+                      big_integer const& e, uint32_t *scratch) {
+    size_t n = ctx.size(), bits = 32 * e.digits_qty(), k = window_size(bits);
+    size_t entries = (size_t) 1 << k;
+
+    std::vector<uint32_t> table(n * entries), entry(n);
+    std::copy(one, one + n, table.data());
+    for (size_t i = 1; i < entries; ++i) {
+        ctx.mul(&table[i * n], &table[(i - 1) * n], x, scratch);
+    }
+
+    std::copy(one, one + n, res);
+    for (size_t top = (bits + k - 1) / k * k; top > 0; top -= k) {
+        size_t value = 0;
+        for (size_t pos = top - 1; pos != top - k - 1; --pos) {
+            value = (value << 1) | (pos < bits ? get_bit(e, pos) : 0);
+            ctx.sqr(res, res, scratch);
+        }
+
+        std::fill(entry.begin(), entry.end(), 0);
+        for (size_t i = 0; i < entries; ++i) {
+            uint32_t mask = 0 - (uint32_t) (i == value);
+            for (size_t j = 0; j < n; ++j) {
+                entry[j] |= table[i * n + j] & mask;
+            }
+        }
+        ctx.mul(res, res, entry.data(), scratch);
+    }
+}
+
+#endif //BIGINT_POWERING_H
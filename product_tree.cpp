@@ -0,0 +1,118 @@
+#include "product_tree.h"
+#include "powering.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <assert.h>
+
+const uint32_t LOG2_BASE = 32;
+// Nodes of at least that many digits pass scaled fractions down the remainder tree,
+// below Karatsuba's threshold a product costs as much as a division
+const size_t SCALED_REMAINDER_THRESHOLD = 32;
+
+namespace {
+    // Digits [lo, hi) of |a|
+    big_integer digit_slice(big_integer const &a, size_t lo, size_t hi) {
+        std::vector<uint32_t> digits(std::max(a.digits_qty(), hi));
+        to_digits(a, digits.data(), digits.size());
+        return from_digits(digits.data() + lo, hi - lo);
+    }
+
+    bool scaled(big_integer const &node) {
+        return node.digits_qty() >= SCALED_REMAINDER_THRESHOLD;
+    }
+
+    /*
+     * Fraction t = (x mod P) / P of node P is kept as floor(t * 2^(32 * k)) with
+     * k = precision(P, guard). Going down to a child multiplies it by the sibling
+     * and at worst doubles the error, so guard bits of the tree depth plus three
+     * keep the error of t * m below 1/2 at every node m.
+     */
+    size_t precision(big_integer const &node, size_t guard) {
+        return (bit_length(node) + guard + LOG2_BASE - 1) / LOG2_BASE;
+    }
+
+    // Nearest integer to t * P, which is x mod P up to wrapping around P
+    big_integer unscale(big_integer const &t, big_integer const &node, size_t guard) {
+        int32_t shift = (int32_t) (LOG2_BASE * precision(node, guard));
+        big_integer res = (t * node + (big_integer(1) << (shift - 1))) >> shift;
+        return res == node ? 0 : res;
+    }
+}
+
+big_integer const &subproduct_tree::product() const {
+    return levels.back()[0];
+}
+
+size_t subproduct_tree::size() const {
+    return levels[0].size();
+}
+
+std::vector<big_integer> multiply_pairs(std::vector<big_integer> const &values) {
+    std::vector<big_integer> res((values.size() + 1) / 2);
+    parallel_for(res.size(), [&](size_t i) {
+        res[i] = 2 * i + 1 < values.size() ? values[2 * i] * values[2 * i + 1] : values[2 * i];
+    });
+    return res;
+}
+
+subproduct_tree product_tree(std::vector<big_integer> const &factors) {
+    assert (!factors.empty());
+
+    subproduct_tree res;
+    res.levels.push_back(factors);
+    while (res.levels.back().size() > 1) {
+        std::vector<big_integer> level = multiply_pairs(res.levels.back());
+        res.levels.push_back(std::move(level));
+    }
+    return res;
+}
+
+std::vector<big_integer> remainder_tree(big_integer const &x, subproduct_tree const &tree) {
+    size_t guard = tree.levels.size() + 2;
+    big_integer const &root = tree.product();
+
+    big_integer r = x % root;
+    if (r < 0) {
+        r += root;
+    }
+    std::vector<big_integer> values(1);
+    std::vector<char> fractions(1, scaled(root));
+    values[0] = fractions[0] ? (r << (int32_t) (LOG2_BASE * precision(root, guard))) / root : r;
+
+    for (size_t level = tree.levels.size() - 1; level-- > 0;) {
+        std::vector<big_integer> const &nodes = tree.levels[level], &parents = tree.levels[level + 1];
+        std::vector<big_integer> below(nodes.size());
+        std::vector<char> below_fractions(nodes.size());
+
+        parallel_for(nodes.size(), [&](size_t i) {
+            big_integer const &value = values[i / 2];
+            size_t sibling = i ^ 1;
+            if (sibling >= nodes.size()) {
+                below[i] = value;
+                below_fractions[i] = fractions[i / 2];
+                return;
+            }
+            if (!fractions[i / 2]) {
+                below[i] = value % nodes[i];
+                return;
+            }
+
+            // Fraction of the child is the fractional part of the parent's one times the sibling
+            size_t top = precision(parents[i / 2], guard), k = precision(nodes[i], guard);
+            big_integer t = digit_slice(value * nodes[sibling], top - k, top);
+            below_fractions[i] = scaled(nodes[i]);
+            below[i] = below_fractions[i] ? t : unscale(t, nodes[i], guard);
+        });
+
+        values.swap(below);
+        fractions.swap(below_fractions);
+    }
+
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (fractions[i]) {
+            values[i] = unscale(values[i], tree.levels[0][i], guard);
+        }
+    }
+    return values;
+}
@@ -0,0 +1,37 @@
+#ifndef BIGINT_PRODUCT_TREE_H
+#define BIGINT_PRODUCT_TREE_H
+
+#include "big_integer.h"
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Subproduct tree: levels[0] are the factors, every next level holds
+ * products of adjacent pairs of the previous one (the last element of an odd
+ * level is carried up as is), and levels.back() holds only the product of all
+ * factors. Products are balanced, so building the tree costs about
+ * log(n) multiplications of the whole product.
+ */
+struct subproduct_tree {
+    std::vector<std::vector<big_integer>> levels;
+
+    big_integer const& product() const;
+    size_t size() const;
+};
+
+// Products of adjacent pairs, the last value of an odd count is carried as is; pairs run in parallel on the default pool
+std::vector<big_integer> multiply_pairs(std::vector<big_integer> const& values);
+
+// Factors must be positive, every level is multiply_pairs of the one below
+subproduct_tree product_tree(std::vector<big_integer> const& factors);
+
+/*
+ * x mod every factor of the tree, remainders are from [0, m).
+ * x is reduced modulo the product once, large nodes then pass down
+ * the scaled fraction (x mod P) / P, which needs only multiplications,
+ * small ones fall back to plain remainders. Nodes of a level run in parallel.
+ */
+std::vector<big_integer> remainder_tree(big_integer const& x, subproduct_tree const& tree);
+
+#endif //BIGINT_PRODUCT_TREE_H
@@ -0,0 +1,148 @@
+#include "reduction.h"
+#include "kernels.h"
+#include "product_tree.h"
+
+#include <assert.h>
+
+const uint32_t LOG2_BASE = 32;
+
+namespace {
+    // Leaves every column below 2^32, the carry of a column is at most 2^32
+    void propagate_columns(std::vector<uint64_t> &columns) {
+        uint64_t carry = 0;
+        for (uint64_t &column : columns) {
+            uint64_t low = (column & UINT32_MAX) + carry;
+            carry = (column >> LOG2_BASE) + (low >> LOG2_BASE);
+            column = low & UINT32_MAX;
+        }
+        for (; carry != 0; carry >>= LOG2_BASE) {
+            columns.push_back(carry & UINT32_MAX);
+        }
+    }
+
+    big_integer from_columns(std::vector<uint64_t> columns, bool negative) {
+        propagate_columns(columns);
+        std::vector<uint32_t> digits(columns.begin(), columns.end());
+        return from_digits(digits.data(), digits.size(), negative);
+    }
+}
+
+sum_accumulator::sum_accumulator() : unpropagated(0) {}
+
+void sum_accumulator::propagate() {
+    propagate_columns(columns[0]);
+    propagate_columns(columns[1]);
+    unpropagated = 0;
+}
+
+// Columns stay below 2^64 as long as at most 2^32 - 1 summands of 32-bit digits are unpropagated
+void sum_accumulator::add(uint32_t const *digits, size_t n, bool negative) {
+    if (unpropagated == UINT32_MAX) {
+        propagate();
+    }
+    ++unpropagated;
+    std::vector<uint64_t> &target = columns[negative];
+    if (target.size() < n) {
+        target.resize(n, 0);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        target[i] += digits[i];
+    }
+}
+
+sum_accumulator &sum_accumulator::operator+=(big_integer const &x) {
+    size_t n = x.digits_qty();
+    if (scratch.size() < n) {
+        scratch.resize(n);
+    }
+    to_digits(x, scratch.data(), n);
+    add(scratch.data(), n, x < 0);
+    return *this;
+}
+
+sum_accumulator &sum_accumulator::operator+=(sum_accumulator other) {
+    other.propagate();
+    if (unpropagated == UINT32_MAX) {
+        propagate();
+    }
+    ++unpropagated;
+    for (size_t sign = 0; sign < 2; ++sign) {
+        std::vector<uint64_t> &target = columns[sign];
+        if (target.size() < other.columns[sign].size()) {
+            target.resize(other.columns[sign].size(), 0);
+        }
+        for (size_t i = 0; i < other.columns[sign].size(); ++i) {
+            target[i] += other.columns[sign][i];
+        }
+    }
+    return *this;
+}
+
+big_integer sum_accumulator::value() const {
+    return from_columns(columns[0], false) + from_columns(columns[1], true);
+}
+
+void sum_accumulator::clear() {
+    columns[0].clear();
+    columns[1].clear();
+    unpropagated = 0;
+}
+
+// Scratch holds the digits of a, the digits of b and their product, nothing is allocated once it is large enough
+void sum_accumulator::add_product(big_integer const &a, big_integer const &b, bool negative) {
+    size_t an = a.digits_qty(), bn = b.digits_qty();
+    if (scratch.size() < 2 * (an + bn)) {
+        scratch.resize(2 * (an + bn));
+    }
+    uint32_t *x = scratch.data(), *y = x + an, *r = y + bn;
+    to_digits(a, x, an);
+    to_digits(b, y, bn);
+    if (an < bn) {
+        std::swap(x, y);
+        std::swap(an, bn);
+    }
+    bool parallel = bn >= PARALLEL_MUL_THRESHOLD && thread_count() > 1;
+    (parallel ? mul_parallel : mul)(r, x, an, y, bn);
+    add(r, an + bn, negative);
+}
+
+void addmul(sum_accumulator &acc, big_integer const &a, big_integer const &b) {
+    acc.add_product(a, b, (a < 0) != (b < 0));
+}
+
+void submul(sum_accumulator &acc, big_integer const &a, big_integer const &b) {
+    acc.add_product(a, b, (a < 0) == (b < 0));
+}
+
+big_integer dot(big_integer const *a, big_integer const *b, size_t n) {
+    size_t parts = n >= PARALLEL_SUM_THRESHOLD ? thread_count() : 1;
+    std::vector<sum_accumulator> partial(parts);
+    parallel_for(parts, [&](size_t p) {
+        for (size_t i = n * p / parts; i < n * (p + 1) / parts; ++i) {
+            addmul(partial[p], a[i], b[i]);
+        }
+    });
+    for (size_t p = 1; p < parts; ++p) {
+        partial[0] += partial[p];
+    }
+    return partial[0].value();
+}
+
+big_integer dot(std::vector<big_integer> const &a, std::vector<big_integer> const &b) {
+    assert (a.size() == b.size());
+    return dot(a.data(), b.data(), a.size());
+}
+
+big_integer product(std::vector<big_integer> values) {
+    if (values.empty()) {
+        return 1;
+    }
+    while (values.size() > 1) {
+        std::stable_sort(values.begin(), values.end(), [](big_integer const &a, big_integer const &b) {
+            return a.digits_qty() < b.digits_qty();
+        });
+        // The longest value is left over from an odd round and waits for a partner of its size
+        values = multiply_pairs(values);
+    }
+    return values[0];
+}
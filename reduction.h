@@ -0,0 +1,86 @@
+#ifndef BIGINT_REDUCTION_H
+#define BIGINT_REDUCTION_H
+
+#include "big_integer.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+// Sums and dot products of at least that many terms are split between the threads of the default pool
+const size_t PARALLEL_SUM_THRESHOLD = 4096;
+
+/*
+ * Carry-save sum: digits of every summand are added into 64-bit columns
+ * and carries are propagated only once per 2^32 - 1 summands, so adding
+ * a value neither allocates nor normalizes. Magnitudes of positive and
+ * negative summands are kept apart and subtracted once at the end.
+ */
+struct sum_accumulator {
+    sum_accumulator();
+
+    sum_accumulator& operator+=(big_integer const& x);
+    sum_accumulator& operator+=(sum_accumulator other);
+
+    big_integer value() const;
+    // Back to zero, the buffers are kept for the next sum
+    void clear();
+
+    // acc += a * b and acc -= a * b, the product is added to the columns straight from a scratch buffer
+    friend void addmul(sum_accumulator& acc, big_integer const& a, big_integer const& b);
+    friend void submul(sum_accumulator& acc, big_integer const& a, big_integer const& b);
+
+private:
+    std::vector<uint64_t> columns[2];
+    std::vector<uint32_t> scratch;
+    uint32_t unpropagated;
+
+    void propagate();
+    // Adds the magnitude of n digits as one more summand
+    void add(uint32_t const *digits, size_t n, bool negative);
+    void add_product(big_integer const& a, big_integer const& b, bool negative);
+};
+
+void addmul(sum_accumulator& acc, big_integer const& a, big_integer const& b);
+void submul(sum_accumulator& acc, big_integer const& a, big_integer const& b);
+
+// Sum of a[i] * b[i] for i from [0, n), every product goes into one sum_accumulator
+big_integer dot(big_integer const *a, big_integer const *b, size_t n);
+// a and b must have equal size
+big_integer dot(std::vector<big_integer> const& a, std::vector<big_integer> const& b);
+
+// Every round sorts the values by length and multiplies neighbours, so operands are of about the same length
+big_integer product(std::vector<big_integer> values);
+
+template <typename It>
+big_integer sum(It first, It last) {
+    size_t n = std::distance(first, last);
+    size_t parts = n >= PARALLEL_SUM_THRESHOLD ? thread_count() : 1;
+    std::vector<It> bounds(1, first);
+    for (size_t p = 0; p < parts; ++p) {
+        It next = bounds.back();
+        std::advance(next, n * (p + 1) / parts - n * p / parts);
+        bounds.push_back(next);
+    }
+
+    std::vector<sum_accumulator> partial(parts);
+    parallel_for(parts, [&](size_t p) {
+        for (It it = bounds[p]; it != bounds[p + 1]; ++it) {
+            partial[p] += *it;
+        }
+    });
+    for (size_t p = 1; p < parts; ++p) {
+        partial[0] += partial[p];
+    }
+    return partial[0].value();
+}
+
+template <typename It>
+big_integer product(It first, It last) {
+    return product(std::vector<big_integer>(first, last));
+}
+
+#endif //BIGINT_REDUCTION_H
@@ -0,0 +1,270 @@
+#include "serialization.h"
+#include "kernels.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+const size_t HEADER_BYTES = 8;
+const size_t DIGIT_BYTES = 4;
+const uint32_t LOG2_BASE = 32;
+// Varints of at most that many bytes are decoded from one 64-bit load
+const size_t SHORT_VARINT_BYTES = 8;
+const uint64_t CONTINUATION_BITS = 0x8080808080808080ull;
+
+namespace {
+    // Byte by byte, so the buffer needs no alignment and the host any byte order,
+    // compilers turn these into single loads and stores on little-endian machines
+    uint32_t load_digit(uint8_t const *p) {
+        return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+    }
+
+    void store_digit(uint8_t *p, uint32_t digit) {
+        p[0] = (uint8_t) digit;
+        p[1] = (uint8_t) (digit >> 8);
+        p[2] = (uint8_t) (digit >> 16);
+        p[3] = (uint8_t) (digit >> 24);
+    }
+
+    uint64_t load_word(uint8_t const *p) {
+        return load_digit(p) | (uint64_t) load_digit(p + DIGIT_BYTES) << LOG2_BASE;
+    }
+
+    // Significant digits of a, none for zero
+    size_t length(big_integer const &a) {
+        return a == 0 ? 0 : a.digits_qty();
+    }
+
+    // Inverse of zigzag for z below 2^63
+    big_integer unzigzag(uint64_t z) {
+        return (z & 1) != 0 ? -(int64_t) (z >> 1) - 1 : (int64_t) (z >> 1);
+    }
+
+    /*
+     * Decodes a varint of at most eight bytes at once: the first byte without
+     * the high bit ends it, and the seven-bit groups are packed together by
+     * halving the gaps between them, pairs to 14 bits, fours to 28 and all to 56.
+     * Returns the number of bytes, 0 if the varint is longer.
+     */
+    size_t decode_short(uint64_t word, uint64_t &z) {
+        uint64_t ends = ~word & CONTINUATION_BITS;
+        if (ends == 0) {
+            return 0;
+        }
+        size_t bytes = (__builtin_ctzll(ends) + 1) / 8;
+        if (bytes < SHORT_VARINT_BYTES) {
+            word &= ((uint64_t) 1 << (8 * bytes)) - 1;
+        }
+        word = ((word & 0x7f007f007f007f00ull) >> 1) | (word & 0x007f007f007f007full);
+        word = ((word & 0x3fff00003fff0000ull) >> 2) | (word & 0x00003fff00003fffull);
+        z = ((word & 0x0fffffff00000000ull) >> 4) | (word & 0x000000000fffffffull);
+        return bytes;
+    }
+}
+
+size_t serialized_size(big_integer const &a) {
+    return HEADER_BYTES + DIGIT_BYTES * length(a);
+}
+
+void serialize(big_integer const &a, std::vector<uint8_t> &buffer) {
+    size_t n = length(a), start = buffer.size();
+    buffer.resize(start + HEADER_BYTES + DIGIT_BYTES * n);
+    uint8_t *p = buffer.data() + start;
+    uint64_t header = (uint64_t) n << 1 | (a < 0);
+    store_digit(p, (uint32_t) header);
+    store_digit(p + DIGIT_BYTES, (uint32_t) (header >> LOG2_BASE));
+    for (size_t i = 0; i < n; ++i) {
+        store_digit(p + HEADER_BYTES + DIGIT_BYTES * i, a.get_digit(i, false));
+    }
+}
+
+size_t serialized_length(uint8_t const *data, size_t size) {
+    if (size < HEADER_BYTES) {
+        return 0;
+    }
+    uint64_t n = load_word(data) >> 1;
+    return n <= (size - HEADER_BYTES) / DIGIT_BYTES ? HEADER_BYTES + DIGIT_BYTES * n : 0;
+}
+
+size_t deserialize(uint8_t const *data, size_t size, big_integer &res) {
+    if (serialized_length(data, size) == 0) {
+        return 0;
+    }
+    big_integer_view view(data, size);
+    res = view.to_big_integer();
+    return view.bytes();
+}
+
+// Leading zero digits of a foreign buffer are skipped, so the view is as canonical as a big_integer
+big_integer_view::big_integer_view(uint8_t const *data, size_t size) {
+    // Checked in every build, the buffer may come from anywhere
+    size_t length = serialized_length(data, size);
+    if (length == 0) {
+        throw std::invalid_argument("big_integer_view: incomplete value");
+    }
+    digits = data + HEADER_BYTES;
+    uint64_t header = load_word(data);
+    n = (size_t) (header >> 1);
+    while (n > 0 && get_digit(n - 1) == 0) {
+        --n;
+    }
+    sign = (header & 1) != 0 && n > 0;
+    bytes_qty = length;
+}
+
+bool big_integer_view::negative() const {
+    return sign;
+}
+
+size_t big_integer_view::digits_qty() const {
+    return n;
+}
+
+uint32_t big_integer_view::get_digit(size_t pos) const {
+    return pos < n ? load_digit(digits + DIGIT_BYTES * pos) : 0;
+}
+
+size_t big_integer_view::bytes() const {
+    return bytes_qty;
+}
+
+big_integer big_integer_view::to_big_integer() const {
+    std::vector<uint32_t> value(n);
+    for (size_t i = 0; i < n; ++i) {
+        value[i] = load_digit(digits + DIGIT_BYTES * i);
+    }
+    return from_digits(value.data(), n, sign);
+}
+
+int compare(big_integer_view const &a, big_integer const &b) {
+    bool b_negative = b < 0;
+    if (a.sign != b_negative) {
+        return a.sign ? -1 : 1;
+    }
+    int res = 0;
+    size_t bn = length(b);
+    if (a.n != bn) {
+        res = a.n < bn ? -1 : 1;
+    } else {
+        for (size_t i = bn; i-- > 0;) {
+            uint32_t x = a.get_digit(i), y = b.get_digit(i, false);
+            if (x != y) {
+                res = x < y ? -1 : 1;
+                break;
+            }
+        }
+    }
+    return a.sign ? -res : res;
+}
+
+/*
+ * With t = |a| - 1 for negative a and |a| otherwise, z is t shifted up by one
+ * with the sign as its lowest bit, so its bits are taken from the digits of t
+ * without building z. Values up to 63 bits go through one machine word.
+ */
+void encode_varint(big_integer const &a, std::vector<uint8_t> &buffer) {
+    bool negative = a < 0;
+    size_t n = a.digits_qty();
+    if (n <= 2) {
+        uint64_t t = ((uint64_t) a.get_digit(1, false) << LOG2_BASE | a.get_digit(0, false)) - negative;
+        if (t >> 63 == 0) {
+            uint64_t z = t << 1 | negative;
+            for (; z >= 0x80; z >>= 7) {
+                buffer.push_back((uint8_t) (z | 0x80));
+            }
+            buffer.push_back((uint8_t) z);
+            return;
+        }
+    }
+
+    std::vector<uint32_t> t(n);
+    to_digits(a, t.data(), n);
+    if (negative) {
+        sub_1(t.data(), t.data(), n, 1);
+    }
+    while (t[n - 1] == 0) {
+        --n;
+    }
+    size_t bits = 1 + LOG2_BASE * n - __builtin_clz(t[n - 1]), bytes = (bits + 6) / 7;
+    uint64_t pending = negative;
+    size_t pending_bits = 1, next = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        if (pending_bits < 7 && next < n) {
+            pending |= (uint64_t) t[next++] << pending_bits;
+            pending_bits += LOG2_BASE;
+        }
+        buffer.push_back((uint8_t) ((pending & 0x7f) | (i + 1 < bytes ? 0x80 : 0)));
+        pending >>= 7;
+        pending_bits -= std::min<size_t>(pending_bits, 7);
+    }
+}
+
+// Long varints collect z digit by digit, then undo the zigzag in place
+size_t decode_varint(uint8_t const *data, size_t size, big_integer &res) {
+    uint64_t z;
+    if (size >= SHORT_VARINT_BYTES) {
+        size_t bytes = decode_short(load_word(data), z);
+        if (bytes != 0) {
+            res = unzigzag(z);
+            return bytes;
+        }
+    }
+
+    size_t bytes = 0;
+    while (bytes < size && (data[bytes] & 0x80) != 0) {
+        ++bytes;
+    }
+    if (bytes == size) {
+        return 0;
+    }
+    ++bytes;
+
+    std::vector<uint32_t> digits;
+    uint64_t pending = 0;
+    size_t pending_bits = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        pending |= (uint64_t) (data[i] & 0x7f) << pending_bits;
+        pending_bits += 7;
+        if (pending_bits >= LOG2_BASE) {
+            digits.push_back((uint32_t) pending);
+            pending >>= LOG2_BASE;
+            pending_bits -= LOG2_BASE;
+        }
+    }
+    digits.push_back((uint32_t) pending);
+
+    bool negative = (digits[0] & 1) != 0;
+    size_t n = digits.size();
+    rshift(digits.data(), digits.data(), n, 1);
+    if (negative) {
+        digits.push_back(add_1(digits.data(), digits.data(), n, 1));
+    }
+    res = from_digits(digits.data(), digits.size(), negative);
+    return bytes;
+}
+
+void encode_varints(std::vector<big_integer> const &values, std::vector<uint8_t> &buffer) {
+    for (big_integer const &a : values) {
+        encode_varint(a, buffer);
+    }
+}
+
+// Small values are decoded straight from 64-bit loads as long as eight bytes are left
+size_t decode_varints(uint8_t const *data, size_t size, std::vector<big_integer> &res) {
+    size_t pos = 0;
+    while (pos < size) {
+        uint64_t z;
+        size_t bytes = size - pos >= SHORT_VARINT_BYTES ? decode_short(load_word(data + pos), z) : 0;
+        if (bytes != 0) {
+            res.push_back(unzigzag(z));
+        } else {
+            big_integer a;
+            bytes = decode_varint(data + pos, size - pos, a);
+            if (bytes == 0) {
+                break;
+            }
+            res.push_back(a);
+        }
+        pos += bytes;
+    }
+    return pos;
+}
@@ -0,0 +1,72 @@
+#ifndef BIGINT_SERIALIZATION_H
+#define BIGINT_SERIALIZATION_H
+
+#include "big_integer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Binary form of a big_integer, everything little-endian:
+ * an 8-byte header n * 2 + sign followed by the n digits of the absolute
+ * value, 4 bytes each, without leading zeros (zero has no digits at all).
+ * Converting is a copy of the digits instead of a quadratic change of base.
+ */
+
+// Bytes of the binary form of a
+size_t serialized_size(big_integer const& a);
+// Appends the binary form of a to buffer
+void serialize(big_integer const& a, std::vector<uint8_t>& buffer);
+// Bytes of the value at the start of data, 0 if size is too short to hold all of it
+size_t serialized_length(uint8_t const *data, size_t size);
+// Reads the value at the start of data into res, returns the bytes read or 0 if the value is incomplete
+size_t deserialize(uint8_t const *data, size_t size, big_integer& res);
+
+/*
+ * Value in binary form read in place, from a memory-mapped file or a network
+ * buffer, without copying its digits. The buffer must outlive the view.
+ */
+struct big_integer_view {
+    // Throws std::invalid_argument unless data starts with a complete value
+    big_integer_view(uint8_t const *data, size_t size);
+
+    bool negative() const;
+    size_t digits_qty() const;
+    // Digit pos of the absolute value, zero above the highest one
+    uint32_t get_digit(size_t pos) const;
+    // Bytes taken in the buffer, the next value starts right after them
+    size_t bytes() const;
+
+    big_integer to_big_integer() const;
+
+    // -1, 0 or 1 like a <=> b, read straight from the buffer
+    friend int compare(big_integer_view const& a, big_integer const& b);
+
+private:
+    uint8_t const *digits;
+    size_t n;
+    bool sign;
+    size_t bytes_qty;
+};
+
+int compare(big_integer_view const& a, big_integer const& b);
+
+/*
+ * Variable-length form for streams of mostly small values: the zigzag
+ * number z = 2a for a >= 0 and -2a - 1 for a < 0 in LEB128, seven bits
+ * per byte from the lowest ones, the high bit set on all bytes but the last.
+ * Values below 2^6 in absolute value take one byte, below 2^13 two and so on.
+ */
+
+// Appends the varint of a to buffer
+void encode_varint(big_integer const& a, std::vector<uint8_t>& buffer);
+// Reads the varint at the start of data into res, returns the bytes read or 0 if it is incomplete
+size_t decode_varint(uint8_t const *data, size_t size, big_integer& res);
+
+// Appends the varints of all values one after another
+void encode_varints(std::vector<big_integer> const& values, std::vector<uint8_t>& buffer);
+// Appends every complete varint of data to res, returns the bytes read, an incomplete tail is left unread
+size_t decode_varints(uint8_t const *data, size_t size, std::vector<big_integer>& res);
+
+#endif //BIGINT_SERIALIZATION_H
@@ -0,0 +1,217 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    thread_local thread_pool const *current_pool = nullptr;
+    thread_local size_t current_queue = 0;
+
+    std::mutex default_lock;
+    std::unique_ptr<thread_pool> default_instance;
+    size_t default_threads = 1;
+}
+
+// The last queue is shared by the threads outside the pool
+thread_pool::thread_pool(size_t workers) : pending(0), stop(false) {
+    for (size_t i = 0; i <= workers; ++i) {
+        queues.emplace_back(new task_queue);
+    }
+    for (size_t i = 0; i < workers; ++i) {
+        this->workers.emplace_back([this, i] { work(i); });
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock);
+        stop = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+size_t thread_pool::size() const {
+    return workers.size();
+}
+
+size_t thread_pool::own_queue() const {
+    return current_pool == this ? current_queue : queues.size() - 1;
+}
+
+// pending is raised first, so a sleeping worker never misses a task
+void thread_pool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock);
+        ++pending;
+    }
+    task_queue &queue = *queues[own_queue()];
+    {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+bool thread_pool::run_pending() {
+    std::function<void()> task;
+    if (!take(own_queue(), task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+// Newest own task first, then the oldest one of the others
+bool thread_pool::take(size_t self, std::function<void()> &task) {
+    for (size_t i = 0; i < queues.size(); ++i) {
+        task_queue &queue = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        --pending;
+        return true;
+    }
+    return false;
+}
+
+void thread_pool::work(size_t self) {
+    current_pool = this;
+    current_queue = self;
+    std::function<void()> task;
+    while (true) {
+        if (take(self, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(sleep_lock);
+        wake.wait(guard, [this] { return stop || pending > 0; });
+        if (stop && pending == 0) {
+            return;
+        }
+    }
+}
+
+task_group::task_group(thread_pool &pool) : pool(pool), running(0) {}
+
+// Exceptions stay with the group, a destructor must not throw
+task_group::~task_group() {
+    join();
+}
+
+void task_group::spawn(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        ++running;
+    }
+    pool.submit([this, task] {
+        struct finisher {
+            task_group &group;
+            ~finisher() {
+                group.finish();
+            }
+        } finish_guard{*this};
+        try {
+            task();
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(lock);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    });
+}
+
+// Notifies under the lock, so the group is not destroyed before the notification ends
+void task_group::finish() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (--running == 0) {
+        done.notify_all();
+    }
+}
+
+/*
+ * Runs pending tasks while there are any, then sleeps until the group
+ * is done. The sleep is cut short now and then to help with tasks that
+ * the group's own tasks spawned in the meantime.
+ */
+void task_group::join() {
+    while (true) {
+        if (pool.run_pending()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(lock);
+        if (done.wait_for(guard, std::chrono::milliseconds(1), [this] { return running == 0; })) {
+            return;
+        }
+    }
+}
+
+void task_group::wait() {
+    join();
+    std::exception_ptr first;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        std::swap(first, error);
+    }
+    if (first) {
+        std::rethrow_exception(first);
+    }
+}
+
+thread_pool &default_pool() {
+    std::lock_guard<std::mutex> guard(default_lock);
+    if (!default_instance) {
+        default_instance.reset(new thread_pool(default_threads - 1));
+    }
+    return *default_instance;
+}
+
+void set_thread_count(size_t n) {
+    if (n == 0) {
+        n = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::lock_guard<std::mutex> guard(default_lock);
+    if (n != default_threads) {
+        default_threads = n;
+        default_instance.reset();
+    }
+}
+
+size_t thread_count() {
+    std::lock_guard<std::mutex> guard(default_lock);
+    return default_threads;
+}
+
+void parallel_for(size_t n, std::function<void(size_t)> const &f) {
+    size_t tasks = std::min(thread_count(), n);
+    if (tasks <= 1) {
+        for (size_t i = 0; i < n; ++i) {
+            f(i);
+        }
+        return;
+    }
+    task_group group(default_pool());
+    for (size_t t = 1; t < tasks; ++t) {
+        group.spawn([&f, n, tasks, t] {
+            for (size_t i = t; i < n; i += tasks) {
+                f(i);
+            }
+        });
+    }
+    for (size_t i = 0; i < n; i += tasks) {
+        f(i);
+    }
+    group.wait();
+}
@@ -0,0 +1,89 @@
+#ifndef BIGINT_THREAD_POOL_H
+#define BIGINT_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Work-stealing pool: every worker owns a deque, takes its own tasks from
+ * the back and steals the oldest tasks of the others from the front, so
+ * the big subproblems spawned first are the ones moving between threads.
+ * Threads outside the pool submit to one more shared deque.
+ * Waiting for a task group runs pending tasks instead of blocking,
+ * so nested fork-join never deadlocks even with no workers at all.
+ */
+struct thread_pool {
+    explicit thread_pool(size_t workers);
+    ~thread_pool();
+
+    size_t size() const;
+
+    // The task must not throw, task_group catches for the tasks it spawns
+    void submit(std::function<void()> task);
+    // Runs one pending task if there is any, returns whether it did
+    bool run_pending();
+
+private:
+    struct task_queue {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<task_queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> pending;
+    std::mutex sleep_lock;
+    std::condition_variable wake;
+    bool stop;
+
+    size_t own_queue() const;
+    bool take(size_t self, std::function<void()>& task);
+    void work(size_t self);
+};
+
+/*
+ * Fork-join over a pool, the destructor waits for all spawned tasks.
+ * The first exception thrown by a task is kept and rethrown by wait(),
+ * the other tasks still run to the end.
+ */
+struct task_group {
+    explicit task_group(thread_pool& pool);
+    ~task_group();
+
+    void spawn(std::function<void()> task);
+    void wait();
+
+private:
+    thread_pool& pool;
+    size_t running;
+    std::exception_ptr error;
+    std::mutex lock;
+    std::condition_variable done;
+
+    void finish();
+    void join();
+};
+
+/*
+ * Pool shared by parallel arithmetic. It has thread_count() - 1 workers,
+ * the calling thread is the last one. The count is 1 by default, which
+ * keeps everything sequential, and 0 stands for the hardware concurrency.
+ * It must not be changed while other threads do arithmetic.
+ */
+thread_pool& default_pool();
+void set_thread_count(size_t n);
+size_t thread_count();
+
+// f(i) for every i from [0, n) on the default pool, indices are dealt round-robin
+// between thread_count() tasks so that uneven iterations share out
+void parallel_for(size_t n, std::function<void(size_t)> const& f);
+
+#endif //BIGINT_THREAD_POOL_H